@@ -2,15 +2,55 @@
 #include <vector>
 #include <string>
 #include <map>
-#include <queue>
-#include <sstream>
+#include <deque>
 #include <fstream>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <climits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#define TOMASULO_HAS_MMAP 1
+#define TOMASULO_HAS_DIRENT 1
+#endif
 
 // --- Definições Globais e Mapeamentos ---
 const int NUM_FP_REGISTERS = 32;
-const int ROB_SIZE = 16;
+const int ROB_SIZE = 16;         // Tamanho padrão do ROB (configurável com ROB_SIZE)
+const int ISSUE_WIDTH = 1;       // Instruções despachadas por ciclo (configurável com ISSUE_WIDTH)
+const int COMMIT_WIDTH = 1;      // Instruções confirmadas por ciclo (configurável com COMMIT_WIDTH)
+const int SSIT_SIZE = 1024;      // Entradas da tabela de store sets (configurável com SSIT_SIZE)
+const float VALOR_MEMORIA_PADRAO = 99.0; // Valor lido de endereços nunca escritos
+const int DCACHE_ASSOC = 4;      // Associatividade padrão da cache de dados (DCACHE_ASSOC)
+const int DCACHE_LINE_SIZE = 64; // Bytes por linha (DCACHE_LINE_SIZE)
+const int MEM_LATENCY = 20;      // Ciclos extras de uma falta na cache (MEM_LATENCY)
+const int PREFETCH_QUEUE_SIZE = 16; // Pedidos de prefetch aguardando porta de memória
+const int IQ_SIZE = 16;          // Instruções decodificadas esperando o issue (IQ_SIZE)
+const int BYTES_INSTRUCAO = 4;   // Endereço de uma instrução na cache de instruções = PC * 4
+const int VPT_SIZE = 1024;       // Entradas da tabela do preditor de valores (VPT_SIZE)
+const int VP_CONFIANCA_MAX = 7;  // Contador de confiança de 3 bits por entrada
+const int VP_LIMIAR = 3;         // Confiança mínima para usar a previsão
+const int CACHE_FORMATO = 1;     // Versão do formato das entradas do cache de resultados
+const int CACHE_MAX_MB = 64;     // Tamanho padrão do cache de resultados em disco (--cache-max-mb)
+const int HOST_MIN_RS_POR_PARTE = 256; // Menor partição de RSs que vale uma thread do host
+const long long MAX_INSTRUCOES_EXPANDIDAS = 8000000; // Instruções de uma thread depois de expandir os REPEAT
 
 enum OpCode
 {
@@ -23,6 +63,105 @@ enum OpCode
     UNKNOWN
 };
 
+// Política de desambiguação de memória para loads (MEM_DEP)
+enum ModoDependenciaMemoria
+{
+    MEMDEP_CONSERVATIVE, // Load espera todos os stores anteriores terem endereço
+    MEMDEP_STORE_SETS,   // Load passa stores sem endereço, exceto os previstos pelo preditor
+    MEMDEP_SPECULATIVE   // Load sempre passa stores sem endereço (sem preditor)
+};
+
+// Eventos de atividade contados em cada estrutura (base do modelo de energia)
+enum EventoAtividade
+{
+    EV_RS_WRITE,   // Escrita em estação de reserva (alocação no issue ou operando vindo do CDB)
+    EV_RS_COMPARE, // Comparação de tag no wakeup (Qj/Qk contra cada tag do CDB)
+    EV_ROB_READ,
+    EV_ROB_WRITE,
+    EV_RF_READ,    // Leitura do banco de registradores no issue
+    EV_RF_WRITE,   // Escrita do banco de registradores no commit
+    EV_RAT_READ,   // Leitura do status dos registradores (renomeação)
+    EV_RAT_WRITE,
+    EV_CDB,        // Transmissão no CDB
+    EV_MEM_READ,
+    EV_MEM_WRITE,
+    EV_FU_ADDD,    // Operações nas unidades funcionais, por opcode
+    EV_FU_SUBD,
+    EV_FU_MULTD,
+    EV_FU_DIVD,
+    EV_FU_LD,      // Cálculo de endereço
+    EV_FU_SD,
+    EV_DCACHE,     // Acesso à cache de dados (demanda ou preenchimento)
+    EV_VPT,        // Consulta ou treino da tabela do preditor de valores
+    NUM_EVENTOS
+};
+
+// Nome no arquivo de entrada (ENERGY <EVENTO> <pJ>) e energia padrão por acesso, em pJ.
+// Os padrões são apenas ordens de grandeza plausíveis; use ENERGY para a sua tecnologia.
+struct EventoInfo
+{
+    const char *nome;
+    double energia_pj;
+};
+const EventoInfo EventosInfo[NUM_EVENTOS] = {
+    {"RS_WRITE", 1.0}, {"RS_COMPARE", 0.1}, {"ROB_READ", 1.5}, {"ROB_WRITE", 2.0},
+    {"RF_READ", 1.0}, {"RF_WRITE", 1.5}, {"RAT_READ", 0.5}, {"RAT_WRITE", 0.7},
+    {"CDB", 3.0}, {"MEM_READ", 10.0}, {"MEM_WRITE", 12.0},
+    {"FU_ADDD", 5.0}, {"FU_SUBD", 5.0}, {"FU_MULTD", 15.0}, {"FU_DIVD", 40.0},
+    {"FU_LD", 1.0}, {"FU_SD", 1.0}, {"DCACHE", 5.0}, {"VPT", 2.0}};
+const double ENERGIA_ESTATICA_PJ = 20.0; // Energia estática por ciclo (ENERGY STATIC <pJ>)
+
+EventoAtividade eventoFU(int op)
+{
+    return (EventoAtividade)(EV_FU_ADDD + op); // Mesma ordem do enum OpCode
+}
+
+// Prefetcher de dados (PREFETCHER)
+enum TipoPrefetcher
+{
+    PF_NONE,
+    PF_NEXT_LINE,
+    PF_STRIDE,
+    PF_STREAM
+};
+
+// Previsão de valor dos loads (VALUE_PRED)
+enum TipoPreditorValor
+{
+    VP_NONE,
+    VP_LAST_VALUE, // Prevê o último valor carregado pelo mesmo PC
+    VP_STRIDE      // Prevê último valor + passo entre os dois últimos
+};
+
+// Política do estágio de seleção quando estações prontas disputam um recurso (SELECT_POLICY)
+enum PoliticaSelecao
+{
+    SEL_OLDEST,   // Mais velha primeiro (matriz de idade)
+    SEL_POSITION, // Menor posição no vetor de estações primeiro
+    SEL_RANDOM    // Ordem aleatória (semente SELECT_SEED)
+};
+
+// SMT: ordem em que as threads disputam a largura de despacho (FETCH_POLICY)
+enum PoliticaFetch
+{
+    FETCH_ROUND_ROBIN, // Prioridade gira entre as threads a cada ciclo
+    FETCH_ICOUNT       // Prioridade para a thread com menos instruções esperando nas RSs
+};
+
+// SMT: divisão do ROB entre as threads (ROB_PARTITION)
+enum ParticaoROB
+{
+    ROB_SHARED, // Qualquer thread usa qualquer entrada livre, até ROB_SIZE no total
+    ROB_STATIC  // Cada thread tem ROB_SIZE / número de threads entradas
+};
+
+// Onde ficam os resultados especulativos (RENAME_MODE)
+enum ModoRenomeacao
+{
+    RENAME_ROB, // Valor na entrada do ROB, copiado para o banco arquitetural no commit
+    RENAME_PRF  // Banco físico unificado com lista livre (estilo R10K); o ROB guarda só metadados
+};
+
 enum ROBestado
 {
     Issue,
@@ -31,36 +170,98 @@ enum ROBestado
     Commit
 };
 
-// Tabela de mapeamento para leitura de arquivo
-const std::map<std::string, OpCode> OpCodeMap = {
-    {"ADDD", ADD_D}, {"SUBD", SUB_D}, {"MULTD", MUL_D}, {"DIVD", DIV_D}, {"LD", L_D}, {"SD", S_D}};
+// --- Tokens da leitura de arquivo ---
+// Um token é uma fatia do buffer de entrada: aponta direto para o texto do arquivo, sem cópia.
+struct Token
+{
+    const char *inicio;
+    size_t tamanho;
+
+    bool equals(const char *s) const
+    {
+        return std::strlen(s) == tamanho && std::memcmp(inicio, s, tamanho) == 0;
+    }
+    std::string str() const { return std::string(inicio, tamanho); }
+};
+
+// Tabela de mapeamento para leitura de arquivo (forma do simulador e forma MIPS)
+struct OpCodeNome
+{
+    const char *nome;
+    OpCode op;
+};
+const OpCodeNome OpCodeNomes[] = {
+    {"ADDD", ADD_D}, {"ADD.D", ADD_D}, {"SUBD", SUB_D}, {"SUB.D", SUB_D},
+    {"MULTD", MUL_D}, {"MUL.D", MUL_D}, {"DIVD", DIV_D}, {"DIV.D", DIV_D},
+    {"LD", L_D}, {"L.D", L_D}, {"SD", S_D}, {"S.D", S_D}};
 
-OpCode stringToOpCode(const std::string &opStr)
+OpCode tokenToOpCode(const Token &t)
 {
-    auto it = OpCodeMap.find(opStr);
-    if (it != OpCodeMap.end())
+    for (const auto &entrada : OpCodeNomes)
     {
-        return it->second;
+        size_t n = std::strlen(entrada.nome);
+        if (n != t.tamanho)
+            continue;
+        size_t i = 0;
+        while (i < n && std::toupper((unsigned char)t.inicio[i]) == entrada.nome[i])
+            i++;
+        if (i == n)
+            return entrada.op;
     }
     return UNKNOWN;
 }
 
-int registerNameToIndex(const std::string &regName)
+// "F12" / "R1" -> 12 / 1. Retorna -1 se não for um registrador válido.
+int tokenToRegisterIndex(const Token &t)
 {
-    if (regName.empty())
+    if (t.tamanho < 2 || t.tamanho > 3)
+        return -1;
+    char c = t.inicio[0];
+    if (c != 'F' && c != 'f' && c != 'R' && c != 'r')
         return -1;
-    if (regName[0] == 'F' || regName[0] == 'f' || regName[0] == 'R' || regName[0] == 'r')
+    int indice = 0;
+    for (size_t i = 1; i < t.tamanho; ++i)
     {
-        try
-        {
-            return std::stoi(regName.substr(1));
-        }
-        catch (...)
-        {
+        if (t.inicio[i] < '0' || t.inicio[i] > '9')
             return -1;
-        }
+        indice = indice * 10 + (t.inicio[i] - '0');
+    }
+    return (indice < NUM_FP_REGISTERS) ? indice : -1;
+}
+
+bool tokenToDouble(const Token &t, double &valor)
+{
+    char buffer[32];
+    if (t.tamanho == 0 || t.tamanho >= sizeof(buffer))
+        return false;
+    std::memcpy(buffer, t.inicio, t.tamanho);
+    buffer[t.tamanho] = '\0';
+    char *fim = nullptr;
+    valor = std::strtod(buffer, &fim);
+    return fim == buffer + t.tamanho;
+}
+
+bool tokenToInt(const Token &t, long long &valor)
+{
+    size_t i = 0;
+    bool negativo = false;
+    if (t.tamanho > 0 && (t.inicio[0] == '-' || t.inicio[0] == '+'))
+    {
+        negativo = (t.inicio[0] == '-');
+        i = 1;
+    }
+    if (i == t.tamanho || t.tamanho - i > 18)
+        return false;
+    valor = 0;
+    for (; i < t.tamanho; ++i)
+    {
+        if (t.inicio[i] < '0' || t.inicio[i] > '9')
+            return false;
+        valor = valor * 10 + (t.inicio[i] - '0');
     }
-    return -1;
+    if (negativo)
+        valor = -valor;
+    return true;
 }
 
 // --- CLASSE INSTRUÇÃO ---
@@ -72,6 +273,8 @@ public:
     int src1_reg;
     int src2_reg;
     int imediato;
+    int pc = -1;          // Instrução estática (usada pelos preditores; repetida em REPEAT)
+    long long indice = -1; // Posição na sequência dinâmica (para rebuscar após squash)
 
     Instrucao(OpCode operation, int dest, int src1, int src2, int imm = 0)
         : op(operation), dest_reg(dest), src1_reg(src1), src2_reg(src2), imediato(imm) {}
@@ -100,6 +303,40 @@ public:
     }
 };
 
+// --- FILA DE INSTRUÇÕES ---
+// Sequência dinâmica do programa em memória (blocos REPEAT já expandidos);
+// front()/pop_front() avançam a busca e redirect() volta a busca para uma
+// instrução já despachada (recuperação após squash).
+class FilaInstrucoes
+{
+private:
+    std::vector<Instrucao> programa;
+    size_t pc = 0;
+
+public:
+    void push_back(const Instrucao &inst)
+    {
+        programa.push_back(inst);
+        programa.back().indice = (long long)programa.size() - 1;
+    }
+    bool empty() const { return pc >= programa.size(); }
+    size_t size() const { return programa.size() - pc; }
+    const Instrucao &front() const { return programa[pc]; }
+    void pop_front() { pc++; }
+    const Instrucao &operator[](size_t i) const { return programa[pc + i]; }
+    void redirect(long long indice) { pc = (size_t)indice; }
+
+    // Repete as instruções de [inicio, fim) mais 'vezes' vezes (expansão de REPEAT)
+    void repete(size_t inicio, size_t fim, long long vezes)
+    {
+        programa.reserve(programa.size() + (fim - inicio) * (size_t)vezes);
+        for (long long v = 0; v < vezes; ++v)
+            for (size_t i = inicio; i < fim; ++i)
+                push_back(programa[i]);
+    }
+    size_t total() const { return programa.size(); }
+};
+
 // --- CLASSE ESTAÇÃO DE RESERVA ---
 class EstacaoReserva
 {
@@ -114,6 +351,7 @@ public:
     int Dest = 0;
     long long A = 0;
     int ciclosfaltantes = 0;
+    bool selecionada = false; // Venceu a seleção em andamento (unidade funcional ou CDB)
 
     EstacaoReserva(int rs_id) : id(rs_id) {}
 
@@ -125,6 +363,111 @@ public:
         Qj = Qk = Dest = 0;
         A = 0;
         ciclosfaltantes = 0;
+        selecionada = false;
+    }
+};
+
+// Índice do bit menos significativo ligado (v != 0)
+inline int primeiroBit(unsigned long long v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int i = 0;
+    while (!(v & 1ULL))
+    {
+        v >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+// --- CONJUNTO DE ESTAÇÕES DE RESERVA ---
+// Estações de uma classe (ADD, MULT, LOAD ou STORE) com uma máscara de livres: o issue
+// acha a estação livre de menor índice direto pela máscara, sem percorrer o vetor.
+// 'base' é o índice global da primeira estação (usado pela matriz de idade).
+class ConjuntoRS
+{
+private:
+    std::vector<EstacaoReserva> estacoes;
+    std::vector<unsigned long long> livres; // Bit i ligado = estação i livre
+
+public:
+    int base = 0;
+
+    void emplace_back(int id)
+    {
+        estacoes.emplace_back(id);
+        size_t i = estacoes.size() - 1;
+        if (i / 64 >= livres.size())
+            livres.push_back(0);
+        livres[i / 64] |= 1ULL << (i % 64);
+    }
+    size_t size() const { return estacoes.size(); }
+    bool empty() const { return estacoes.empty(); }
+    EstacaoReserva &operator[](size_t i) { return estacoes[i]; }
+    std::vector<EstacaoReserva>::iterator begin() { return estacoes.begin(); }
+    std::vector<EstacaoReserva>::iterator end() { return estacoes.end(); }
+    std::vector<EstacaoReserva>::const_iterator begin() const { return estacoes.begin(); }
+    std::vector<EstacaoReserva>::const_iterator end() const { return estacoes.end(); }
+
+    // Índice da estação livre de menor posição (-1 = todas ocupadas); marca como ocupada
+    int aloca()
+    {
+        for (size_t w = 0; w < livres.size(); ++w)
+        {
+            if (livres[w] != 0)
+            {
+                int b = primeiroBit(livres[w]);
+                livres[w] &= ~(1ULL << b);
+                return (int)(w * 64) + b;
+            }
+        }
+        return -1;
+    }
+
+    void libera(EstacaoReserva &rs)
+    {
+        size_t i = (size_t)(rs.id - 1);
+        rs.clear();
+        livres[i / 64] |= 1ULL << (i % 64);
+    }
+};
+
+// --- MATRIZ DE IDADE ---
+// Uma linha por estação de reserva (índice global): ao alocar a estação i, a linha i recebe
+// as estações ocupadas naquele momento, ou seja, todas as mais velhas que i. Assim
+// "j é mais velha que i" é um único bit, sem guardar números de sequência.
+class MatrizIdade
+{
+private:
+    size_t palavras = 0;
+    std::vector<unsigned long long> linhas;  // n linhas de 'palavras' palavras
+    std::vector<unsigned long long> ocupadas;
+
+public:
+    void resize(int n)
+    {
+        palavras = ((size_t)n + 63) / 64;
+        linhas.assign((size_t)n * palavras, 0);
+        ocupadas.assign(palavras, 0);
+    }
+
+    void aloca(int i)
+    {
+        // A nova estação é mais nova que todas: some da coluna i das outras linhas
+        size_t n = linhas.size() / std::max<size_t>(palavras, 1);
+        for (size_t r = 0; r < n; ++r)
+            linhas[r * palavras + i / 64] &= ~(1ULL << (i % 64));
+        std::copy(ocupadas.begin(), ocupadas.end(), linhas.begin() + (size_t)i * palavras);
+        ocupadas[i / 64] |= 1ULL << (i % 64);
+    }
+    void libera(int i) { ocupadas[i / 64] &= ~(1ULL << (i % 64)); }
+
+    bool maisVelha(int j, int i) const
+    {
+        return (linhas[(size_t)i * palavras + j / 64] >> (j % 64)) & 1ULL;
     }
 };
 
@@ -153,6 +496,48 @@ public:
             status[reg_index] = 0;
         }
     }
+    void reset() { std::fill(status.begin(), status.end(), 0); }
+};
+
+// --- BANCO DE REGISTRADORES FÍSICOS (RENAME_MODE PRF) ---
+// Modo R10K: os resultados vivem num banco físico unificado e a renomeação mapeia
+// registrador arquitetural -> físico. O físico antigo de um destino só volta para a
+// lista livre quando a instrução que o substituiu confirma.
+class BancoRegistradoresFisicos
+{
+public:
+    std::vector<float> valores;
+    std::vector<char> pronto; // Valor já escrito (transmitido no CDB)
+
+private:
+    std::vector<int> livres;
+
+public:
+    size_t minimo_livres = 0;
+
+    void resize(int n)
+    {
+        valores.assign(n, 0.0);
+        pronto.assign(n, 1);
+        livres.clear();
+        for (int p = n - 1; p >= 0; --p)
+            livres.push_back(p); // O topo da pilha é P0
+        minimo_livres = livres.size();
+    }
+    int size() const { return (int)valores.size(); }
+    size_t disponiveis() const { return livres.size(); }
+
+    int aloca()
+    {
+        if (livres.empty())
+            return -1;
+        int p = livres.back();
+        livres.pop_back();
+        pronto[p] = 0;
+        minimo_livres = std::min(minimo_livres, livres.size());
+        return p;
+    }
+    void libera(int p) { livres.push_back(p); }
 };
 
 // --- CLASSE BUFFER DE REORDENAÇÃO (ROB) ---
@@ -163,9 +548,40 @@ public:
     ROBestado estado = Issue;
     int reddestido = -1; // Registrador destino (ou fonte, no caso do S.D)
     float valor = 0.0; // Valor a ser escrito (no reg ou na mem)
+    bool transmitido = false; // Valor já passou pelo CDB (pode ser lido direto do ROB no issue)
     bool enderecocerto = false;
     long long enderecoMemoria = 0;
     OpCode op = UNKNOWN;
+    long long seq = 0; // Ordem de despacho (idade da instrução)
+    int pc = -1;
+    long long indice = -1;
+
+    // Estado de desambiguação dos loads
+    bool acessou_memoria = false;  // Load já leu o valor (memória ou forwarding)
+    long long fonte_seq = -1;      // seq do store que forneceu o valor (-1 = memória)
+    bool especulativo = false;     // Load passou na frente de store sem endereço
+    bool retido_preditor = false;  // Load foi segurado pelo preditor de store sets
+
+    // Previsão de valor dos loads
+    bool previsto = false;         // Valor previsto ainda não verificado (consumidores o usam no issue)
+    bool fez_previsao = false;     // Houve previsão no issue (contada no commit)
+    bool previsao_correta = false; // Resultado da verificação (vale quando fez_previsao)
+    float valor_previsto = 0.0;
+    long long consumidor_seq = -1; // seq do consumidor mais velho do valor previsto (-1 = nenhum)
+
+    // RENAME_MODE PRF: o resultado fica no banco físico; o ROB guarda só os números
+    int preg = -1;         // Registrador físico do destino
+    int preg_antigo = -1;  // Mapeamento anterior do destino (liberado no commit)
+
+    // Regra do commit: um resultado só é confirmado depois de passar pelo CDB (Write
+    // Result), nunca no ciclo seguinte ao fim da execução. A RS só é liberada quando
+    // transmite; confirmar antes deixava a RS ainda ocupada executando de novo sobre
+    // a entrada já liberada (e, no modo PRF, o commit leria o físico antes da escrita).
+    // Stores não usam o CDB e ficam prontos ao receber endereço e valor.
+    bool prontaParaCommit() const
+    {
+        return ocupado && (op == S_D ? estado == escreveresult : transmitido);
+    }
 
     void clear()
     {
@@ -173,9 +589,24 @@ public:
         estado = Issue;
         reddestido = -1;
         valor = 0.0;
+        transmitido = false;
         enderecocerto = false;
         enderecoMemoria = 0;
         op = UNKNOWN;
+        seq = 0;
+        pc = -1;
+        indice = -1;
+        acessou_memoria = false;
+        fonte_seq = -1;
+        especulativo = false;
+        retido_preditor = false;
+        previsto = false;
+        fez_previsao = false;
+        previsao_correta = false;
+        valor_previsto = 0.0;
+        consumidor_seq = -1;
+        preg = -1;
+        preg_antigo = -1;
     }
 };
 
@@ -185,9 +616,19 @@ private:
     std::vector<ROB_Entry> entries;
     int cabeca = 0;
     int calda = 0;
+    int ocupadas = 0;
+    long long proximo_seq = 1;
 
 public:
-    BufferReordenacao() { entries.resize(ROB_SIZE); }
+    BufferReordenacao(int tamanho = ROB_SIZE) { entries.resize(tamanho); }
+    void resize(int tamanho)
+    {
+        entries.assign(tamanho, ROB_Entry());
+        cabeca = calda = 0;
+        ocupadas = 0;
+    }
+    int size() const { return (int)entries.size(); }
+    int ocupacao() const { return ocupadas; }
     bool isFull() const { return entries[calda].ocupado; }
     bool isEmpty() const { return !entries[cabeca].ocupado && cabeca == calda; }
 
@@ -200,9 +641,13 @@ public:
         entries[calda].op = inst.op;
         entries[calda].reddestido = inst.dest_reg; // Para L.D e Arith, é o destino. Para S.D, é o *valor fonte*.
         entries[calda].estado = Issue;
+        entries[calda].seq = proximo_seq++;
+        entries[calda].pc = inst.pc;
+        entries[calda].indice = inst.indice;
 
         int novatag = calda + 1;
-        calda = (calda + 1) % ROB_SIZE;
+        calda = (calda + 1) % size();
+        ocupadas++;
         return novatag;
     }
 
@@ -228,338 +673,2391 @@ public:
     void advancecabeca()
     {
         entries[cabeca].clear();
-        cabeca = (cabeca + 1) % ROB_SIZE;
+        cabeca = (cabeca + 1) % size();
+        ocupadas--;
     }
-};
-
-// --- CLASSE SIMULADOR TOMASULO ---
-class TomasuloSimulator
-{
-public:
-    std::vector<EstacaoReserva> rs_add;
-    std::vector<EstacaoReserva> rs_mult;
-    std::vector<EstacaoReserva> rs_load;  // <-- NOVO: Load Buffers
-    std::vector<EstacaoReserva> rs_store; // <-- NOVO: Store Buffers
 
-    std::vector<float> fp_registers_values;
-    ModoRegistrador reg_status;
-    BufferReordenacao rob;
-    std::queue<Instrucao> instruction_queue;
+    // Navegação por idade: tag da entrada imediatamente mais velha/mais nova (0 = não há)
+    int olderTag(int rob_tag) const
+    {
+        int idx = rob_tag - 1;
+        if (idx == cabeca)
+            return 0;
+        return (idx - 1 + size()) % size() + 1;
+    }
+    int youngerTag(int rob_tag) const
+    {
+        int idx = rob_tag % size();
+        if (idx == calda)
+            return 0;
+        return idx + 1;
+    }
 
-    std::map<OpCode, int> cycle_times;
-    std::map<OpCode, int> unit_counts;
-    std::map<int, float> cdb_broadcast; // Simula o CDB com Tag->Valor no ciclo atual
+    // Descarta a entrada rob_tag e todas as mais novas; a cauda volta para rob_tag
+    int squashFrom(int rob_tag)
+    {
+        int descartadas = 0;
+        int idx = rob_tag - 1;
+        do
+        {
+            entries[idx].clear();
+            descartadas++;
+            idx = (idx + 1) % size();
+        } while (idx != calda);
+        calda = rob_tag - 1;
+        ocupadas -= descartadas;
+        return descartadas;
+    }
+};
 
-    int clock_cycle = 0;
-    int instructions_committed = 0;
+// --- PREDITOR DE DEPENDÊNCIA DE MEMÓRIA (STORE SETS) ---
+// SSIT indexada pelo PC: cada load/store aponta para um store set (-1 = nenhum).
+// Um load é previsto como dependente de um store anterior do mesmo set, e então
+// espera o endereço desse store antes de acessar a memória. Treinado nas violações.
+class PreditorStoreSets
+{
+private:
+    std::vector<int> ssit;
+    int proximo_set = 0;
 
-    TomasuloSimulator() : fp_registers_values(NUM_FP_REGISTERS, 0.0) {}
+public:
+    PreditorStoreSets() { ssit.assign(SSIT_SIZE, -1); }
+    void resize(int tamanho) { ssit.assign(tamanho, -1); }
 
-    void loadConfiguration(std::ifstream &inputFile);
-    void loadInstructions(std::ifstream &inputFile);
-    void runSimulation();
+    int getSet(int pc) const { return (pc < 0) ? -1 : ssit[pc % ssit.size()]; }
 
-    void issue();
-    void execute();
-    void writeResult();
-    void commit();
+    bool prediz(int load_pc, int store_pc) const
+    {
+        int set = getSet(load_pc);
+        return set != -1 && set == getSet(store_pc);
+    }
 
-    void printSimulatorStatus();
+    // Regras de atribuição do artigo de store sets: cria um set novo, adota o set
+    // existente do outro, ou funde os dois no menor identificador
+    void treinar(int load_pc, int store_pc)
+    {
+        int &set_load = ssit[load_pc % ssit.size()];
+        int &set_store = ssit[store_pc % ssit.size()];
+        if (set_load == -1 && set_store == -1)
+            set_load = set_store = proximo_set++;
+        else if (set_load == -1)
+            set_load = set_store;
+        else if (set_store == -1)
+            set_store = set_load;
+        else
+            set_load = set_store = std::min(set_load, set_store);
+    }
 };
 
-void TomasuloSimulator::loadConfiguration(std::ifstream &inputFile)
+// --- PREDITOR DE VALORES DOS LOADS ---
+// Tabela indexada pelo PC com o último valor confirmado, o passo entre os dois últimos
+// e um contador de confiança. Treinada no commit (em ordem), então instâncias do mesmo
+// load ainda em voo são contadas para prever o valor certo de cada iteração.
+class PreditorValor
 {
-    std::string line, key, typeStr;
-    int value;
-    while (std::getline(inputFile, line) && line.find("CONFIG_BEGIN") == std::string::npos)
-        ;
+private:
+    struct Entrada
+    {
+        bool valida = false;
+        float ultimo = 0.0;
+        float passo = 0.0;
+        int confianca = 0;
+    };
+    std::vector<Entrada> tabela;
+
+public:
+    TipoPreditorValor tipo = VP_NONE;
+
+    PreditorValor() { tabela.resize(VPT_SIZE); }
+    void resize(int tamanho) { tabela.assign(tamanho, Entrada()); }
+    bool ativo() const { return tipo != VP_NONE; }
 
-    while (std::getline(inputFile, line) && line.find("CONFIG_END") == std::string::npos)
+    // em_voo = instâncias mais velhas do mesmo PC ainda não confirmadas
+    bool prediz(int pc, int em_voo, float &valor) const
     {
-        std::stringstream ss(line);
-        ss >> key >> typeStr >> value;
-        OpCode op = stringToOpCode(typeStr);
+        const Entrada &e = tabela[pc % tabela.size()];
+        if (!e.valida || e.confianca < VP_LIMIAR)
+            return false;
+        valor = (tipo == VP_STRIDE) ? e.ultimo + e.passo * (em_voo + 1) : e.ultimo;
+        return true;
+    }
 
-        if (key == "CYCLES" && op != UNKNOWN)
-        {
-            cycle_times[op] = value;
-        }
-        else if ((key == "UNITS" || key == "MEM_UNITS") && op != UNKNOWN)
+    void treinar(int pc, float real)
+    {
+        Entrada &e = tabela[pc % tabela.size()];
+        if (e.valida)
         {
-            if (op == ADD_D || op == SUB_D)
+            float esperado = (tipo == VP_STRIDE) ? e.ultimo + e.passo : e.ultimo;
+            if (esperado == real)
+                e.confianca = std::min(e.confianca + 1, VP_CONFIANCA_MAX);
+            else
             {
-                for (int i = 0; i < value; ++i)
-                    rs_add.emplace_back(i + 1);
-                unit_counts[op] = value;
-            }
-            else if (op == MUL_D || op == DIV_D)
-            {
-                for (int i = 0; i < value; ++i)
-                    rs_mult.emplace_back(i + 1);
-                unit_counts[op] = value;
-            }
-            // --- CORRIGIDO: Adiciona L_D e S_D em buffers separados ---
-            else if (op == L_D)
-            {
-                for (int i = 0; i < value; ++i)
-                    rs_load.emplace_back(i + 1);
-                unit_counts[op] = value;
-            }
-            else if (op == S_D)
-            {
-                for (int i = 0; i < value; ++i)
-                    rs_store.emplace_back(i + 1);
-                unit_counts[op] = value;
+                e.confianca = 0;
+                e.passo = real - e.ultimo;
             }
         }
+        e.ultimo = real;
+        e.valida = true;
     }
-}
+};
 
-void TomasuloSimulator::loadInstructions(std::ifstream &inputFile)
+// --- CACHE DE DADOS (MODELO DE TEMPORIZAÇÃO) ---
+// Associativa por conjunto com LRU. Guarda só as tags e o ciclo em que cada linha chega
+// da memória: os valores continuam vindo do mapa de memória do simulador.
+class CacheDados
 {
-    std::string line, opStr, destStr, src1Str, src2Str;
-    while (std::getline(inputFile, line) && line.find("INSTRUCTIONS_BEGIN") == std::string::npos)
-        ;
-
-    while (std::getline(inputFile, line) && line.find("INSTRUCTIONS_END") == std::string::npos)
+public:
+    struct Linha
     {
-        std::stringstream ss(line);
-        std::vector<std::string> tokens;
-        std::string token;
-        while (ss >> token && token.find('#') == std::string::npos)
-        {
-            tokens.push_back(token);
-        }
-
-        if (tokens.size() < 3)
-            continue;
-
-        opStr = tokens[0];
-        OpCode op = stringToOpCode(opStr);
-        if (op == UNKNOWN)
-            continue;
+        bool valida = false;
+        long long tag = 0;          // Número da linha (endereço / tamanho da linha)
+        long long pronta_ciclo = 0; // Ciclo em que o preenchimento termina
+        long long lru = 0;
+        bool prefetch = false;      // Trazida por prefetch e ainda não usada pela demanda
+    };
 
-        // L.D F1, 0(R1) -> tokens = {LD, F1, 0, R1}
-        // S.D F2, 0(R1) -> tokens = {SD, F2, 0, R1}
+    int num_linhas = 0; // 0 = sem cache (latência fixa de CYCLES LD)
+    int assoc = DCACHE_ASSOC;
+    int tamanho_linha = DCACHE_LINE_SIZE;
 
-        int dest_reg = registerNameToIndex(tokens[1]); // F1 (para L.D) ou F2 (para S.D)
-        int src1_reg = (tokens.size() > 2) ? registerNameToIndex(tokens[2]) : -1; // 0 (imediato)
-        int src2_reg = (tokens.size() > 3) ? registerNameToIndex(tokens[3]) : -1; // R1
-        int imediato = 0;
+private:
+    std::vector<Linha> linhas;
+    int num_conjuntos = 0;
+    long long relogio_lru = 0;
 
-        if (op == L_D || op == S_D)
-        {
-            // O parser assume que 0(R1) são dois tokens "0" e "R1"
-            // Se "0(R1)" for um token só, este parser falha.
-            // Assumindo tokens separados:
-            try { imediato = std::stoi(tokens[2]); } catch(...) { imediato = 0; }
-            src1_reg = src2_reg; // O registrador base (R1)
-            src2_reg = -1;
-        }
+public:
+    bool ativa() const { return num_linhas > 0; }
 
-        instruction_queue.push(Instrucao(op, dest_reg, src1_reg, src2_reg, imediato));
+    void configura()
+    {
+        if (!ativa())
+            return;
+        assoc = std::max(1, std::min(assoc, num_linhas));
+        num_conjuntos = std::max(1, num_linhas / assoc);
+        linhas.assign((size_t)num_conjuntos * assoc, Linha());
     }
-}
-
-// --- FASES DE EXECUÇÃO ---
-
-void TomasuloSimulator::issue()
-{
-    if (instruction_queue.empty() || rob.isFull())
-        return;
-
-    Instrucao current_inst = instruction_queue.front();
-    EstacaoReserva *target_rs = nullptr;
 
-    // --- CORRIGIDO: Lógica de despacho separada ---
+    long long linhaDe(long long endereco) const
+    {
+        long long l = endereco / tamanho_linha;
+        return (endereco < 0 && endereco % tamanho_linha != 0) ? l - 1 : l;
+    }
 
-    // Lógica para RS_ADD/SUB
-    if (current_inst.op == ADD_D || current_inst.op == SUB_D)
+    Linha *procura(long long linha)
     {
-        for (auto &rs : rs_add)
+        size_t base = (size_t)(((linha % num_conjuntos) + num_conjuntos) % num_conjuntos) * assoc;
+        for (int w = 0; w < assoc; ++w)
         {
-            if (!rs.ocupado)
+            Linha &l = linhas[base + w];
+            if (l.valida && l.tag == linha)
             {
-                target_rs = &rs;
-                break;
+                l.lru = ++relogio_lru;
+                return &l;
             }
         }
+        return nullptr;
     }
-    // Lógica para RS_MULT/DIV
-    else if (current_inst.op == MUL_D || current_inst.op == DIV_D)
+
+    // Substitui a linha LRU do conjunto; 'despejada' recebe a vítima (para contar prefetches inúteis)
+    Linha &aloca(long long linha, long long pronta_ciclo, bool prefetch, Linha &despejada)
     {
-        for (auto &rs : rs_mult)
+        size_t base = (size_t)(((linha % num_conjuntos) + num_conjuntos) % num_conjuntos) * assoc;
+        Linha *vitima = &linhas[base];
+        for (int w = 0; w < assoc; ++w)
         {
-            if (!rs.ocupado)
+            Linha &l = linhas[base + w];
+            if (!l.valida)
             {
-                target_rs = &rs;
+                vitima = &l;
                 break;
             }
+            if (l.lru < vitima->lru)
+                vitima = &l;
         }
+        despejada = *vitima;
+        vitima->valida = true;
+        vitima->tag = linha;
+        vitima->pronta_ciclo = pronta_ciclo;
+        vitima->lru = ++relogio_lru;
+        vitima->prefetch = prefetch;
+        return *vitima;
+    }
+};
+
+// --- PREFETCHERS DE DADOS ---
+// Cada prefetcher observa os acessos de demanda dos loads (PC, número da linha, falta)
+// e propõe linhas para buscar. 'grau' é quantas linhas por gatilho e 'distancia' quantas
+// linhas à frente do acesso atual começa a busca.
+class Prefetcher
+{
+protected:
+    int grau;
+    int distancia;
+
+public:
+    Prefetcher(int degree, int distance) : grau(degree), distancia(distance) {}
+    virtual ~Prefetcher() {}
+    virtual const char *nome() const = 0;
+    virtual void observa(int pc, long long linha, bool falta, std::vector<long long> &candidatas) = 0;
+};
+
+// Próxima linha: em cada falta, busca as linhas seguintes
+class PrefetcherProximaLinha : public Prefetcher
+{
+public:
+    PrefetcherProximaLinha(int degree, int distance) : Prefetcher(degree, distance) {}
+    const char *nome() const { return "NEXT_LINE"; }
+    void observa(int, long long linha, bool falta, std::vector<long long> &candidatas)
+    {
+        if (!falta)
+            return;
+        for (int i = 0; i < grau; ++i)
+            candidatas.push_back(linha + distancia + i);
     }
-    // Lógica para RS_LOAD
-    else if (current_inst.op == L_D)
+};
+
+// Stride por PC: aprende o passo (em linhas) de cada load e busca à frente quando
+// o mesmo passo se repete
+class PrefetcherStride : public Prefetcher
+{
+private:
+    struct Entrada
+    {
+        long long ultima_linha = 0;
+        long long passo = 0;
+        int confianca = 0;
+        bool valida = false;
+    };
+    std::map<int, Entrada> tabela;
+
+public:
+    PrefetcherStride(int degree, int distance) : Prefetcher(degree, distance) {}
+    const char *nome() const { return "STRIDE"; }
+    void observa(int pc, long long linha, bool, std::vector<long long> &candidatas)
     {
-        for (auto &rs : rs_load)
+        Entrada &e = tabela[pc];
+        if (e.valida)
         {
-            if (!rs.ocupado)
+            long long passo = linha - e.ultima_linha;
+            if (passo != 0 && passo == e.passo)
+                e.confianca = std::min(e.confianca + 1, 3);
+            else if (passo != 0)
             {
-                target_rs = &rs;
-                break;
+                e.passo = passo;
+                e.confianca = 0;
             }
         }
+        e.ultima_linha = linha;
+        e.valida = true;
+
+        if (e.confianca >= 1)
+        {
+            for (int i = 0; i < grau; ++i)
+                candidatas.push_back(linha + e.passo * (distancia + i));
+        }
     }
-    // Lógica para RS_STORE
-    else if (current_inst.op == S_D)
+};
+
+// Stream: detecta faltas em linhas consecutivas (subindo ou descendo) e, confirmado o
+// fluxo, mantém as próximas linhas dele sendo buscadas à frente do consumo
+class PrefetcherStream : public Prefetcher
+{
+private:
+    static const int NUM_STREAMS = 8;
+    struct Stream
+    {
+        long long ultima_linha = 0;
+        int direcao = 0; // 0 = ainda não confirmado
+        long long lru = 0;
+        bool valido = false;
+    };
+    Stream streams[NUM_STREAMS];
+    long long relogio = 0;
+
+public:
+    PrefetcherStream(int degree, int distance) : Prefetcher(degree, distance) {}
+    const char *nome() const { return "STREAM"; }
+    void observa(int, long long linha, bool falta, std::vector<long long> &candidatas)
     {
-        for (auto &rs : rs_store)
+        relogio++;
+        for (auto &st : streams)
+        {
+            if (!st.valido)
+                continue;
+            long long delta = linha - st.ultima_linha;
+            bool segue = (st.direcao == 0) ? (delta == 1 || delta == -1)
+                                           : (delta * st.direcao > 0 && delta * st.direcao <= distancia + grau);
+            if (delta == 0)
+                return; // Mesma linha do stream: nada novo a buscar
+            if (!segue)
+                continue;
+            if (st.direcao == 0)
+                st.direcao = (delta > 0) ? 1 : -1;
+            st.ultima_linha = linha;
+            st.lru = relogio;
+            for (int i = 0; i < grau; ++i)
+                candidatas.push_back(linha + st.direcao * (distancia + i));
+            return;
+        }
+        if (!falta)
+            return;
+        // Falta fora de qualquer stream: começa um novo no lugar do menos recente
+        Stream *vitima = &streams[0];
+        for (auto &st : streams)
         {
-            if (!rs.ocupado)
+            if (!st.valido)
             {
-                target_rs = &rs;
+                vitima = &st;
                 break;
             }
+            if (st.lru < vitima->lru)
+                vitima = &st;
         }
+        vitima->valido = true;
+        vitima->ultima_linha = linha;
+        vitima->direcao = 0;
+        vitima->lru = relogio;
+    }
+};
+
+Prefetcher *criaPrefetcher(TipoPrefetcher tipo, int grau, int distancia)
+{
+    switch (tipo)
+    {
+    case PF_NEXT_LINE:
+        return new PrefetcherProximaLinha(grau, distancia);
+    case PF_STRIDE:
+        return new PrefetcherStride(grau, distancia);
+    case PF_STREAM:
+        return new PrefetcherStream(grau, distancia);
+    default:
+        return nullptr;
+    }
+}
+
+// --- AUTO-PROFILER DO SIMULADOR ---
+// Tempo do host gasto em cada fase (steady_clock), para saber onde vai o tempo do
+// próprio simulador. Só existe na build de profile (make profile, -DTOMASULO_PROFILE);
+// nas builds normais PROFILE_FASE e PROFILE_INSTRUCOES não geram código.
+#ifdef TOMASULO_PROFILE
+enum FaseProfiler
+{
+    FASE_ABERTURA,   // Abrir/mapear o arquivo de entrada
+    FASE_LEITURA,    // Passada única de tokenização e leitura
+    FASE_VALIDACAO,  // Verificações e montagem das estruturas depois da leitura
+    FASE_SIMULACAO,  // runSimulation inteiro (contém as fases abaixo)
+    FASE_COMMIT,
+    FASE_WRITE_RESULT,
+    FASE_EXECUTE,
+    FASE_ISSUE,
+    FASE_FETCH,      // Front-end (só com FETCH_WIDTH, IQ_SIZE, ...)
+    FASE_STATUS,     // printSimulatorStatus (trace por ciclo)
+    NUM_FASES
+};
+const char *NomesFases[NUM_FASES] = {"abertura", "leitura", "validacao", "simulacao", "commit",
+                                     "writeResult", "execute", "issue", "fetch", "status"};
+
+struct Profiler
+{
+    double segundos[NUM_FASES] = {};
+    long long chamadas[NUM_FASES] = {};
+    long long instrucoes = 0;
+};
+
+// Mede o escopo em que é criado. Cada TomasuloSimulator tem o próprio Profiler, então a
+// execução de referência do VALUE_PRED não entra nos números da simulação principal.
+class MedeFase
+{
+private:
+    Profiler &profiler;
+    FaseProfiler fase;
+    std::chrono::steady_clock::time_point inicio;
+
+public:
+    MedeFase(Profiler &p, FaseProfiler f) : profiler(p), fase(f), inicio(std::chrono::steady_clock::now()) {}
+    ~MedeFase()
+    {
+        profiler.segundos[fase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+        profiler.chamadas[fase]++;
+    }
+};
+
+#define PROFILE_FASE(fase) MedeFase medidor_fase_(profiler, fase)
+#define PROFILE_INSTRUCOES(n) (profiler.instrucoes += (n))
+
+void imprimeProfiler(std::ostream &out, const Profiler &profiler, long long ciclos)
+{
+    double simulacao = profiler.segundos[FASE_SIMULACAO];
+    double medido = 0.0;
+
+    out << "\n=== PROFILE DO SIMULADOR (tempo do host) ===\n";
+    out << std::left << std::setw(13) << "Fase" << std::setw(12) << "Chamadas" << std::setw(14) << "Tempo (ms)"
+        << std::setw(12) << "us/chamada" << "% simulação\n";
+    for (int f = 0; f < NUM_FASES; ++f)
+    {
+        if (profiler.chamadas[f] == 0)
+            continue;
+        if (f > FASE_SIMULACAO)
+            medido += profiler.segundos[f];
+        out << std::left << std::setw(13) << NomesFases[f] << std::setw(12) << profiler.chamadas[f]
+            << std::setw(14) << std::fixed << std::setprecision(3) << profiler.segundos[f] * 1e3
+            << std::setw(12) << profiler.segundos[f] * 1e6 / profiler.chamadas[f];
+        if (f >= FASE_SIMULACAO && simulacao > 0)
+            out << std::setprecision(1) << 100.0 * profiler.segundos[f] / simulacao;
+        out << "\n";
+    }
+    if (simulacao > 0)
+    {
+        out << std::left << std::setw(13) << "outros" << std::setw(12) << "-" << std::setw(14) << std::setprecision(3)
+            << (simulacao - medido) * 1e3 << std::setw(12) << "-" << std::setprecision(1)
+            << 100.0 * (simulacao - medido) / simulacao << "\n";
+        out << std::setprecision(0);
+        out << "Ciclos simulados por segundo: " << ciclos / simulacao << "\n";
+        out << "Instruções confirmadas por segundo: " << profiler.instrucoes / simulacao << "\n";
+    }
+}
+#else
+#define PROFILE_FASE(fase) ((void)0)
+#define PROFILE_INSTRUCOES(n) ((void)0)
+#endif
+
+// --- CACHE DE RESULTADOS EM DISCO ---
+// Uma entrada por combinação (entrada normalizada, executável do simulador). A entrada é
+// normalizada pelos próprios tokens do leitor: espaços, vírgulas, parênteses, comentários
+// e linhas vazias não mudam a assinatura. Duas funções de hash independentes: a primeira
+// dá o nome do arquivo, a segunda (com o tamanho normalizado) é conferida no acerto.
+class AssinaturaEntrada
+{
+public:
+    unsigned long long h1 = 1469598103934665603ULL; // FNV-1a 64
+    unsigned long long h2 = 5381;                   // djb2 64
+    unsigned long long bytes = 0;
+
+    void adiciona(const char *p, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            unsigned char c = (unsigned char)p[i];
+            h1 = (h1 ^ c) * 1099511628211ULL;
+            h2 = h2 * 33 + c;
+        }
+        bytes += n;
+    }
+    void adicionaLinha(const Token *tokens, int num_tokens)
+    {
+        for (int i = 0; i < num_tokens; ++i)
+        {
+            adiciona(tokens[i].inicio, tokens[i].tamanho);
+            adiciona(i + 1 < num_tokens ? " " : "\n", 1);
+        }
+    }
+};
+
+class CacheResultados
+{
+private:
+    std::string diretorio;
+    size_t max_bytes;
+    unsigned long long versao = 0; // Hash do executável: qualquer recompilação invalida o cache
+
+    static std::string hex(unsigned long long v)
+    {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", v);
+        return buf;
+    }
+    std::string caminho(const AssinaturaEntrada &a) const
+    {
+        return diretorio + "/" + hex(a.h1 ^ versao) + ".res";
+    }
+    std::string cabecalho(const AssinaturaEntrada &a) const
+    {
+        return "TOMASULO_CACHE " + std::to_string(CACHE_FORMATO) + " " + hex(versao) + " " + hex(a.h2) + " " +
+               std::to_string(a.bytes) + "\n";
+    }
+
+public:
+    CacheResultados(const std::string &dir, int max_mb, const char *executavel)
+        : diretorio(dir), max_bytes((size_t)max_mb * 1024 * 1024)
+    {
+        // /proc/self/exe acha o binário mesmo quando chamado pelo PATH
+        AssinaturaEntrada binario;
+        std::ifstream in("/proc/self/exe", std::ios::binary);
+        if (!in.is_open())
+            in.open(executavel, std::ios::binary);
+        char buf[1 << 16];
+        while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+            binario.adiciona(buf, (size_t)in.gcount());
+        if (binario.bytes == 0)
+        {
+            std::string compilacao = __DATE__ " " __TIME__; // Sem o binário, ao menos a data da compilação
+            binario.adiciona(compilacao.data(), compilacao.size());
+        }
+        versao = binario.h1;
+    }
+
+    bool ativo() const
+    {
+#ifdef TOMASULO_HAS_DIRENT
+        struct stat st;
+        return stat(diretorio.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#else
+        return false;
+#endif
+    }
+
+    // Acerto: devolve o resultado guardado e marca a entrada como usada agora (LRU por mtime)
+    bool procura(const AssinaturaEntrada &a, std::string &resultado) const
+    {
+        std::ifstream in(caminho(a), std::ios::binary);
+        if (!in.is_open())
+            return false;
+        std::string linha;
+        if (!std::getline(in, linha) || linha + "\n" != cabecalho(a))
+            return false; // Outra versão do simulador ou colisão do primeiro hash
+        resultado.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+#ifdef TOMASULO_HAS_DIRENT
+        utime(caminho(a).c_str(), nullptr);
+#endif
+        return true;
+    }
+
+    // Grava num temporário e renomeia, para que execuções em paralelo nunca leiam uma
+    // entrada pela metade; depois despeja as menos usadas até caber em max_bytes
+    void guarda(const AssinaturaEntrada &a, const std::string &resultado)
+    {
+        std::string destino = caminho(a);
+        if (cabecalho(a).size() + resultado.size() > max_bytes)
+            return;
+#ifdef TOMASULO_HAS_DIRENT
+        std::string temporario = destino + ".tmp" + std::to_string((long long)getpid());
+#else
+        std::string temporario = destino + ".tmp";
+#endif
+        {
+            std::ofstream out(temporario, std::ios::binary);
+            if (!out.is_open())
+                return;
+            out << cabecalho(a) << resultado;
+            if (!out)
+            {
+                out.close();
+                std::remove(temporario.c_str());
+                return;
+            }
+        }
+        if (std::rename(temporario.c_str(), destino.c_str()) != 0)
+        {
+            std::remove(temporario.c_str());
+            return;
+        }
+        despeja();
+    }
+
+    void despeja()
+    {
+#ifdef TOMASULO_HAS_DIRENT
+        struct Entrada
+        {
+            std::string nome;
+            size_t tamanho;
+            time_t usada;
+        };
+        std::vector<Entrada> entradas;
+        size_t total = 0;
+        DIR *d = opendir(diretorio.c_str());
+        if (d == nullptr)
+            return;
+        while (struct dirent *de = readdir(d))
+        {
+            std::string nome = de->d_name;
+            if (nome.size() < 4 || nome.compare(nome.size() - 4, 4, ".res") != 0)
+                continue;
+            struct stat st;
+            std::string c = diretorio + "/" + nome;
+            if (stat(c.c_str(), &st) != 0)
+                continue;
+            entradas.push_back({c, (size_t)st.st_size, st.st_mtime});
+            total += (size_t)st.st_size;
+        }
+        closedir(d);
+
+        std::sort(entradas.begin(), entradas.end(),
+                  [](const Entrada &x, const Entrada &y) { return x.usada < y.usada; });
+        for (size_t i = 0; i < entradas.size() && total > max_bytes; ++i)
+        {
+            if (std::remove(entradas[i].nome.c_str()) == 0)
+                total -= entradas[i].tamanho;
+        }
+#endif
+    }
+};
+
+// --- POOL DE THREADS DO HOST ---
+// Threads fixas, criadas uma vez, que executam as partes de uma tarefa. Quem chama
+// também pega partes e só retorna quando todas terminaram. Qual thread faz qual parte
+// varia, mas cada parte escreve só no próprio espaço e o simulador junta os resultados
+// na ordem das partes, então a simulação não depende do escalonamento do host.
+class PoolThreads
+{
+private:
+    std::vector<std::thread> trabalhadoras;
+    std::mutex mutex;
+    std::condition_variable cv_tarefa;
+    std::condition_variable cv_fim;
+    const std::function<void(int)> *tarefa = nullptr;
+    int partes = 0;
+    int proxima = 0;    // Próxima parte a ser pega
+    int pendentes = 0;  // Partes ainda não terminadas
+    long long geracao = 0;
+    bool encerrar = false;
+
+    // Pega e executa partes até acabarem; devolve com o mutex travado
+    void executaPartes(std::unique_lock<std::mutex> &trava)
+    {
+        while (proxima < partes)
+        {
+            int k = proxima++;
+            trava.unlock();
+            (*tarefa)(k);
+            trava.lock();
+            if (--pendentes == 0)
+                cv_fim.notify_all();
+        }
+    }
+
+    void laco()
+    {
+        long long vista = 0;
+        std::unique_lock<std::mutex> trava(mutex);
+        while (true)
+        {
+            cv_tarefa.wait(trava, [&] { return encerrar || geracao != vista; });
+            if (encerrar)
+                return;
+            vista = geracao;
+            executaPartes(trava);
+        }
+    }
+
+public:
+    explicit PoolThreads(int num_threads)
+    {
+        for (int i = 1; i < num_threads; ++i) // A thread que chama é a primeira
+            trabalhadoras.emplace_back(&PoolThreads::laco, this);
+    }
+    PoolThreads(const PoolThreads &) = delete;
+    PoolThreads &operator=(const PoolThreads &) = delete;
+
+    ~PoolThreads()
+    {
+        {
+            std::lock_guard<std::mutex> trava(mutex);
+            encerrar = true;
+        }
+        cv_tarefa.notify_all();
+        for (auto &t : trabalhadoras)
+            t.join();
+    }
+
+    int tamanho() const { return (int)trabalhadoras.size() + 1; }
+
+    void executa(int num_partes, const std::function<void(int)> &f)
+    {
+        std::unique_lock<std::mutex> trava(mutex);
+        tarefa = &f;
+        partes = num_partes;
+        proxima = 0;
+        pendentes = num_partes;
+        geracao++;
+        cv_tarefa.notify_all();
+        executaPartes(trava);
+        cv_fim.wait(trava, [&] { return pendentes == 0; });
+        tarefa = nullptr;
+    }
+};
+
+// Uma parte de uma varredura de RSs: mensagens do trace, contadores de atividade e
+// estações encontradas, juntados na ordem das partes depois da varredura. As partes
+// são do simulador e reaproveitadas a cada varredura (reinicia mantém a capacidade)
+struct ParteVarredura
+{
+    std::ostringstream buffer;
+    std::ostream *log = &buffer;
+    long long atividade[NUM_EVENTOS] = {};
+    std::vector<EstacaoReserva *> estacoes;
+    int ocupadas = 0;
+
+    void conta(EventoAtividade evento, long long n = 1) { atividade[evento] += n; }
+    void reinicia()
+    {
+        buffer.str("");
+        buffer.clear();
+        log = &buffer;
+        std::fill(atividade, atividade + NUM_EVENTOS, 0LL);
+        estacoes.clear();
+        ocupadas = 0;
+    }
+};
+
+// --- CONTEXTO DE THREAD (SMT) ---
+// Estado privado de cada thread de hardware: fluxo de instruções, registradores
+// arquiteturais, tabela de renomeação e ROB. As RSs, o CDB, as unidades funcionais,
+// a memória e a cache são compartilhados. As tags do ROB são globais: a thread t
+// usa as tags tag_base+1 .. tag_base+rob.size(), então uma tag numa RS ou no CDB
+// identifica sozinha a thread dona.
+class ContextoThread
+{
+public:
+    int id;
+    int tag_base = 0;
+    FilaInstrucoes instruction_queue;
+    std::vector<float> fp_registers_values;
+    ModoRegistrador reg_status; // Guarda tags globais
+    BufferReordenacao rob;
+    // Front-end (FETCH_WIDTH, IQ_SIZE, ...): buscadas e decodificadas, esperando o issue
+    struct Decodificada
+    {
+        Instrucao inst;
+        int pronta_ciclo; // Fim da decodificação
+    };
+    std::deque<Decodificada> fila_decodificada;
+    int fetch_parado_ate = 0; // Falta na cache de instruções: busca parada até este ciclo
+    bool refaz_falta = false; // Próxima consulta repete o acesso que faltou (não conta acerto)
+
+    std::vector<int> mapa;        // RENAME_MODE PRF: arquitetural -> físico (especulativo)
+    std::vector<int> mapa_commit; // RENAME_MODE PRF: arquitetural -> físico (confirmado)
+
+    int total_instructions = 0;
+    int instructions_committed = 0;
+
+    ContextoThread(int thread_id) : id(thread_id), fp_registers_values(NUM_FP_REGISTERS, 0.0) {}
+
+    ROB_Entry &getEntry(int tag) { return rob.getEntry(tag - tag_base); }
+    int headTag() const { return rob.getHeadIndex() + 1 + tag_base; }
+    int olderTag(int tag) const
+    {
+        int t = rob.olderTag(tag - tag_base);
+        return (t == 0) ? 0 : t + tag_base;
+    }
+    int youngerTag(int tag) const
+    {
+        int t = rob.youngerTag(tag - tag_base);
+        return (t == 0) ? 0 : t + tag_base;
+    }
+};
+
+// --- CLASSE SIMULADOR TOMASULO ---
+class TomasuloSimulator
+{
+public:
+    ConjuntoRS rs_add;
+    ConjuntoRS rs_mult;
+    ConjuntoRS rs_load;  // <-- NOVO: Load Buffers
+    ConjuntoRS rs_store; // <-- NOVO: Store Buffers
+
+    // Estágio de seleção: quem fica com unidade funcional, porta de memória ou CDB
+    // quando há mais estações prontas que recursos livres no ciclo
+    MatrizIdade idade_rs;
+    PoliticaSelecao select_policy = SEL_OLDEST;
+    std::mt19937 rng_selecao;
+    int unidades_add = 0;  // Unidades funcionais ADD/SUB (0 = uma por estação)
+    int unidades_mult = 0; // Unidades funcionais MULT/DIV (0 = uma por estação)
+    int cdb_width = 0;     // Transmissões por ciclo no CDB (0 = sem limite)
+
+    std::vector<ContextoThread> threads; // Uma por bloco INSTRUCTIONS_BEGIN do arquivo
+    std::vector<std::pair<int, float>> valores_iniciais; // REG <reg> <valor> do arquivo (todas as threads)
+    int rob_size = ROB_SIZE;       // Entradas do ROB no total, somando todas as threads
+    int tag_stride = ROB_SIZE;     // Tags reservadas para cada thread
+    ParticaoROB rob_partition = ROB_SHARED;
+    PoliticaFetch fetch_policy = FETCH_ROUND_ROBIN;
+    int proxima_thread = 0;        // Primeira thread do rodízio no ciclo atual
+
+    // Front-end: desligado, o issue lê direto da fila de instruções (busca ideal)
+    bool front_end = false;
+    int fetch_width = 0;        // Instruções buscadas por ciclo (0 = ISSUE_WIDTH)
+    int decode_latency = 1;     // Ciclos entre a busca e o issue
+    int iq_size = IQ_SIZE;
+    CacheDados icache;          // Mesmo modelo de temporização da cache de dados
+    int icache_miss_latency = MEM_LATENCY;
+
+    ModoRenomeacao rename_mode = RENAME_ROB;
+    int phys_regs = 0;             // PHYS_REGS (0 = 32 por thread + ROB_SIZE)
+    BancoRegistradoresFisicos prf;
+
+    std::map<long long, float> memoria; // Escrita pelos stores no commit
+    CacheDados dcache;
+    int mem_latency = MEM_LATENCY;
+    int mem_ports = 0;                   // Acessos iniciados por ciclo (0 = um por load buffer)
+    int portas_livres = 0;               // Portas ainda livres no ciclo atual
+    TipoPrefetcher tipo_prefetcher = PF_NONE;
+    int prefetch_degree = 1;
+    int prefetch_distance = 1;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::deque<long long> fila_prefetch; // Linhas aguardando porta de memória
+    ModoDependenciaMemoria mem_dep = MEMDEP_CONSERVATIVE;
+    PreditorStoreSets store_sets;
+    PreditorValor preditor_valor;
+
+    std::map<OpCode, int> cycle_times;
+    std::map<OpCode, int> unit_counts;
+    std::map<int, float> cdb_broadcast; // Simula o CDB com Tag->Valor no ciclo atual
+
+    int issue_width = ISSUE_WIDTH;
+    int commit_width = COMMIT_WIDTH;
+
+    int clock_cycle = 0;
+    int instructions_committed = 0;
+
+    // Contadores de atividade e tabela de energia por acesso (pJ)
+    long long atividade[NUM_EVENTOS] = {};
+    double energia_pj[NUM_EVENTOS];
+    double energia_estatica_pj = ENERGIA_ESTATICA_PJ;
+    double clock_ghz = 1.0;
+
+    void conta(EventoAtividade evento, long long n = 1) { atividade[evento] += n; }
+
+    // Estatísticas do caminho de memória
+    long long loads_executados = 0;
+    long long loads_forwarding = 0;        // Valor veio de um store anterior no ROB
+    long long loads_especulativos = 0;     // Passaram na frente de store sem endereço
+    long long especulacoes_corretas = 0;   // Especulativos que chegaram ao commit (stall evitado)
+    long long loads_retidos_preditor = 0;  // Seguros pelo preditor de store sets
+    long long violacoes_memoria = 0;
+    long long instrucoes_descartadas = 0;
+
+    // Estatísticas da cache de dados e do prefetcher
+    long long dcache_acertos = 0;
+    long long dcache_faltas = 0;
+    long long prefetches_emitidos = 0;
+    long long prefetches_uteis = 0;     // Linha de prefetch usada por um load de demanda
+    long long prefetches_tardios = 0;   // Usada, mas o load chegou antes do preenchimento terminar
+    long long prefetches_inuteis = 0;   // Despejada sem nunca ter sido usada
+    long long prefetches_descartados = 0; // Fila cheia
+
+    // Estatísticas do estágio de seleção
+    long long selecao_disputas = 0; // Vezes em que havia mais candidatas que recursos
+    long long selecao_adiadas = 0;  // Candidatas que perderam a disputa e esperaram
+
+    // Estatísticas da previsão de valores
+    long long vp_loads_verificados = 0;
+    long long vp_previsoes = 0;
+    long long vp_corretas = 0;
+    long long vp_incorretas = 0;
+    long long vp_consumos = 0;      // Operandos lidos do valor previsto no issue
+    long long vp_recuperacoes = 0;  // Squashes por previsão errada com consumidores
+    long long vp_descartadas = 0;
+    int ciclos_sem_vp = -1;         // Ciclos da mesma entrada sem VALUE_PRED (-1 = não medido)
+
+    long long stalls_registrador_fisico = 0; // Issues barrados por lista livre vazia (PRF)
+
+    // Estatísticas do front-end
+    long long instrucoes_buscadas = 0;      // Inclui as buscadas de novo depois de squash
+    long long icache_acertos = 0;
+    long long icache_faltas = 0;
+    long long ciclos_fetch_icache = 0;      // Busca parada esperando a cache de instruções
+    long long ciclos_fetch_fila_cheia = 0;  // Busca parada com a fila de decodificadas cheia
+    long long ciclos_issue_faminto = 0;     // Vagas de issue sobrando e nada decodificado pronto
+    long long vagas_issue_famintas = 0;
+    long long ciclos_issue_saturado = 0;    // Vagas sobrando com instrução pronta: back end cheio
+    long long instrucoes_descartadas_fila = 0; // Decodificadas jogadas fora num squash
+
+    // Histogramas de ocupação da largura: [k] = ciclos com k instruções despachadas/confirmadas
+    std::vector<long long> issue_histogram;
+    std::vector<long long> commit_histogram;
+
+    long long input_lines = 0;
+
+    bool imprime_status = true; // Tabelas de estado a cada ciclo (--no-status desliga)
+    bool abortada = false;      // Parada pelo detector de deadlock: o resultado é parcial
+
+    // Passo em paralelo (--host-threads): varreduras de RS divididas em partes contíguas
+    std::unique_ptr<PoolThreads> pool;
+    int partesDe(size_t num_rs) const
+    {
+        if (!pool)
+            return 1;
+        return std::max(1, std::min(pool->tamanho(), (int)(num_rs / HOST_MIN_RS_POR_PARTE)));
+    }
+    std::vector<ParteVarredura> partes_varredura; // Reaproveitadas entre varreduras e ciclos
+    std::vector<ParteVarredura> &partesPara(size_t num_rs)
+    {
+        partes_varredura.resize(partesDe(num_rs));
+        for (auto &parte : partes_varredura)
+            parte.reinicia();
+        return partes_varredura;
+    }
+    void varre(size_t num_rs, std::vector<ParteVarredura> &partes,
+               const std::function<void(ParteVarredura &, size_t, size_t)> &f);
+    void juntaPartes(std::vector<ParteVarredura> &partes);
+
+    // Vencedoras da seleção do estágio em andamento (execute ou CDB), reaproveitado entre
+    // ciclos; as vencedoras ficam marcadas em EstacaoReserva::selecionada até o fim do estágio
+    std::vector<EstacaoReserva *> selecionadas;
+
+    // Cache de resultados: o leitor alimenta a assinatura só quando o cache está ligado
+    bool calcula_assinatura = false;
+    AssinaturaEntrada assinatura;
+
+#ifdef TOMASULO_PROFILE
+    Profiler profiler; // Tempo do host desta simulação (make profile)
+#endif
+
+    TomasuloSimulator() : rng_selecao(1)
+    {
+        // Latências padrão (sobrescritas por CYCLES no arquivo de entrada)
+        cycle_times[ADD_D] = 2;
+        cycle_times[SUB_D] = 2;
+        cycle_times[MUL_D] = 4;
+        cycle_times[DIV_D] = 10;
+        cycle_times[L_D] = 2;
+        cycle_times[S_D] = 2;
+
+        for (int e = 0; e < NUM_EVENTOS; ++e)
+            energia_pj[e] = EventosInfo[e].energia_pj;
+    }
+
+    bool loadInput(const std::string &path);
+    void runSimulation();
+    void printResultados();
+
+    ConjuntoRS &conjuntoDe(OpCode op)
+    {
+        if (op == ADD_D || op == SUB_D)
+            return rs_add;
+        if (op == MUL_D || op == DIV_D)
+            return rs_mult;
+        return (op == L_D) ? rs_load : rs_store;
+    }
+    int indiceGlobal(EstacaoReserva &rs) { return conjuntoDe(rs.op).base + rs.id - 1; }
+    void liberaRS(EstacaoReserva &rs)
+    {
+        idade_rs.libera(indiceGlobal(rs));
+        conjuntoDe(rs.op).libera(rs);
+    }
+    void ordenaSelecao(std::vector<EstacaoReserva *> &candidatas);
+    void seleciona(std::vector<EstacaoReserva *> &candidatas, int limite);
+
+    bool modoPRF() const { return rename_mode == RENAME_PRF; }
+    bool escreveRegistrador(const ROB_Entry &e) const { return e.op != S_D && e.reddestido != -1; }
+    // Resultado de uma instrução: no banco físico (PRF) ou na própria entrada do ROB.
+    // Stores guardam o dado na entrada nos dois modos (faz o papel da fila de stores).
+    float &resultado(ROB_Entry &e) { return (modoPRF() && e.preg >= 0) ? prf.valores[e.preg] : e.valor; }
+    // Tag que acorda os dependentes no CDB: físico + 1 no modo PRF, tag do ROB no modo ROB
+    int tagCDB(int rob_tag)
+    {
+        if (!modoPRF())
+            return rob_tag;
+        int p = robEntry(rob_tag).preg;
+        return (p >= 0) ? p + 1 : rob_tag;
+    }
+
+    ContextoThread &threadDaTag(int rob_tag) { return threads[(rob_tag - 1) / tag_stride]; }
+    ROB_Entry &robEntry(int rob_tag) { return threadDaTag(rob_tag).getEntry(rob_tag); }
+    int totalInstrucoes() const;
+    int robOcupacao() const;
+    std::string rotuloThread(const ContextoThread &t) const;
+
+    void fetch();
+    std::vector<int> ordemThreads();
+    void fetchThread(ContextoThread &t, int &buscadas);
+    void issue();
+    bool issueOne(ContextoThread &t);
+    bool temInstrucao(const ContextoThread &t) const;
+    bool loadPodeAcessar(int load_tag, float &valor);
+    int acessaCache(int pc, long long endereco);
+    void emitePrefetches();
+    void checkMemoryViolation(int store_tag);
+    void verificaPrevisao(int load_tag);
+    void squash(int rob_tag);
+    void execute();
+    void writeResult();
+    void commit();
+
+    void printSimulatorStatus();
+    void printStatistics();
+    void printEnergy();
+};
+
+// --- LEITURA DA ENTRADA ---
+
+// Arquivo de entrada inteiro em memória: mapeado com mmap quando disponível,
+// ou lido de uma vez para um buffer caso contrário.
+class ArquivoMapeado
+{
+private:
+    const char *dados = nullptr;
+    size_t tamanho = 0;
+    bool mapeado = false;
+    std::string copia;
+
+public:
+    ArquivoMapeado() {}
+    ArquivoMapeado(const ArquivoMapeado &) = delete;
+    ArquivoMapeado &operator=(const ArquivoMapeado &) = delete;
+
+    ~ArquivoMapeado()
+    {
+#ifdef TOMASULO_HAS_MMAP
+        if (mapeado)
+            munmap((void *)dados, tamanho);
+#endif
+    }
+
+    bool abrir(const std::string &caminho)
+    {
+#ifdef TOMASULO_HAS_MMAP
+        int fd = open(caminho.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        {
+            void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+                dados = (const char *)p;
+                tamanho = (size_t)st.st_size;
+                mapeado = true;
+                close(fd);
+                return true;
+            }
+        }
+        close(fd);
+#endif
+        // Sem mmap (ou arquivo vazio/especial): lê tudo para um único buffer
+        std::ifstream in(caminho, std::ios::binary);
+        if (!in.is_open())
+            return false;
+        copia.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        dados = copia.data();
+        tamanho = copia.size();
+        return true;
+    }
+
+    const char *begin() const { return dados; }
+    const char *end() const { return dados + tamanho; }
+};
+
+// Leitor de passada única: percorre o buffer linha a linha, quebrando cada linha
+// em tokens que apontam para o próprio buffer (sem stringstream nem vetores por linha).
+// Separadores: espaço, tab, vírgula e parênteses, então "L.D F0, 8(R1)" e
+// "LD F0 8 R1" geram os mesmos tokens. Erros são reportados como arquivo:linha.
+class LeitorEntrada
+{
+private:
+    static const int MAX_TOKENS = 8;
+
+    TomasuloSimulator &sim;
+    std::string nome_arquivo;
+    long long linha = 0;
+    Token tokens[MAX_TOKENS];
+    int num_tokens = 0;
+
+    int proximo_pc = 0;           // PC estático da próxima instrução lida
+    bool em_repeat = false;
+    size_t inicio_repeat = 0;     // Primeira instrução do corpo do REPEAT na fila
+    long long repeticoes = 0;
+
+    enum Secao
+    {
+        FORA,
+        CONFIG,
+        INSTRUCOES
+    };
+
+    bool erro(const std::string &mensagem)
+    {
+        std::cerr << nome_arquivo << ":" << linha << ": erro: " << mensagem << "\n";
+        return false;
+    }
+
+    static bool isSeparador(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == '(' || c == ')';
+    }
+
+    // Quebra [p, fim) em tokens, parando no comentário '#'
+    bool tokenizar(const char *p, const char *fim)
+    {
+        num_tokens = 0;
+        while (p < fim)
+        {
+            while (p < fim && isSeparador(*p))
+                p++;
+            if (p == fim || *p == '#')
+                break;
+            const char *inicio = p;
+            while (p < fim && !isSeparador(*p) && *p != '#')
+                p++;
+            if (num_tokens == MAX_TOKENS)
+                return erro("tokens demais na linha");
+            tokens[num_tokens].inicio = inicio;
+            tokens[num_tokens].tamanho = (size_t)(p - inicio);
+            num_tokens++;
+        }
+        return true;
+    }
+
+    bool lerInteiroPositivo(const Token &t, int &valor)
+    {
+        long long v = 0;
+        if (!tokenToInt(t, v) || v <= 0 || v > 1000000)
+            return erro("valor inválido '" + t.str() + "' (esperado inteiro positivo)");
+        valor = (int)v;
+        return true;
+    }
+
+    bool lerConfiguracao();
+    bool lerInstrucao();
+
+public:
+    LeitorEntrada(TomasuloSimulator &simulador, const std::string &arquivo)
+        : sim(simulador), nome_arquivo(arquivo) {}
+
+    bool ler(const char *p, const char *fim);
+    long long linhasLidas() const { return linha; }
+};
+
+bool LeitorEntrada::lerConfiguracao()
+{
+    const Token &chave = tokens[0];
+
+    // Parâmetros de largura da máquina: "CHAVE <VALOR>"
+    if (chave.equals("ISSUE_WIDTH") || chave.equals("COMMIT_WIDTH") || chave.equals("ROB_SIZE") ||
+        chave.equals("CDB_WIDTH"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: " + chave.str() + " <valor>");
+        int n = 0;
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        if (chave.equals("ISSUE_WIDTH"))
+            sim.issue_width = n;
+        else if (chave.equals("COMMIT_WIDTH"))
+            sim.commit_width = n;
+        else if (chave.equals("CDB_WIDTH"))
+            sim.cdb_width = n;
+        else
+            sim.rob_size = n;
+        return true;
+    }
+
+    // Estágio de seleção: "SELECT_POLICY OLDEST|POSITION|RANDOM", "SELECT_SEED <VALOR>"
+    if (chave.equals("SELECT_POLICY"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: SELECT_POLICY OLDEST|POSITION|RANDOM");
+        if (tokens[1].equals("OLDEST"))
+            sim.select_policy = SEL_OLDEST;
+        else if (tokens[1].equals("POSITION"))
+            sim.select_policy = SEL_POSITION;
+        else if (tokens[1].equals("RANDOM"))
+            sim.select_policy = SEL_RANDOM;
+        else
+            return erro("política de seleção desconhecida '" + tokens[1].str() + "'");
+        return true;
+    }
+    if (chave.equals("SELECT_SEED"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: SELECT_SEED <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        sim.rng_selecao.seed((unsigned)n);
+        return true;
+    }
+
+    // SMT: "ROB_PARTITION SHARED|STATIC", "FETCH_POLICY ROUND_ROBIN|ICOUNT"
+    if (chave.equals("ROB_PARTITION"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: ROB_PARTITION SHARED|STATIC");
+        if (tokens[1].equals("SHARED"))
+            sim.rob_partition = ROB_SHARED;
+        else if (tokens[1].equals("STATIC"))
+            sim.rob_partition = ROB_STATIC;
+        else
+            return erro("partição de ROB desconhecida '" + tokens[1].str() + "'");
+        return true;
+    }
+    if (chave.equals("FETCH_POLICY"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: FETCH_POLICY ROUND_ROBIN|ICOUNT");
+        if (tokens[1].equals("ROUND_ROBIN"))
+            sim.fetch_policy = FETCH_ROUND_ROBIN;
+        else if (tokens[1].equals("ICOUNT"))
+            sim.fetch_policy = FETCH_ICOUNT;
+        else
+            return erro("política de fetch desconhecida '" + tokens[1].str() + "'");
+        return true;
+    }
+
+    // Renomeação: "RENAME_MODE ROB|PRF", "PHYS_REGS <VALOR>"
+    if (chave.equals("RENAME_MODE"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: RENAME_MODE ROB|PRF");
+        if (tokens[1].equals("ROB"))
+            sim.rename_mode = RENAME_ROB;
+        else if (tokens[1].equals("PRF"))
+            sim.rename_mode = RENAME_PRF;
+        else
+            return erro("modo de renomeação desconhecido '" + tokens[1].str() + "'");
+        return true;
+    }
+    if (chave.equals("PHYS_REGS"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: PHYS_REGS <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        sim.phys_regs = n;
+        return true;
+    }
+
+    // Desambiguação de memória: "MEM_DEP CONSERVATIVE|STORE_SETS|SPECULATIVE", "SSIT_SIZE <VALOR>"
+    if (chave.equals("MEM_DEP"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: MEM_DEP CONSERVATIVE|STORE_SETS|SPECULATIVE");
+        if (tokens[1].equals("CONSERVATIVE"))
+            sim.mem_dep = MEMDEP_CONSERVATIVE;
+        else if (tokens[1].equals("STORE_SETS"))
+            sim.mem_dep = MEMDEP_STORE_SETS;
+        else if (tokens[1].equals("SPECULATIVE"))
+            sim.mem_dep = MEMDEP_SPECULATIVE;
+        else
+            return erro("modo MEM_DEP desconhecido '" + tokens[1].str() + "'");
+        return true;
+    }
+    if (chave.equals("SSIT_SIZE"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: SSIT_SIZE <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        sim.store_sets.resize(n);
+        return true;
+    }
+
+    // Previsão de valores dos loads: "VALUE_PRED NONE|LAST_VALUE|STRIDE", "VPT_SIZE <VALOR>"
+    if (chave.equals("VALUE_PRED"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: VALUE_PRED NONE|LAST_VALUE|STRIDE");
+        if (tokens[1].equals("NONE"))
+            sim.preditor_valor.tipo = VP_NONE;
+        else if (tokens[1].equals("LAST_VALUE"))
+            sim.preditor_valor.tipo = VP_LAST_VALUE;
+        else if (tokens[1].equals("STRIDE"))
+            sim.preditor_valor.tipo = VP_STRIDE;
+        else
+            return erro("preditor de valores desconhecido '" + tokens[1].str() + "'");
+        return true;
+    }
+    if (chave.equals("VPT_SIZE"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: VPT_SIZE <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        sim.preditor_valor.resize(n);
+        return true;
+    }
+
+    // Valor inicial de registrador: "REG <Fn|Rn> <valor>"
+    if (chave.equals("REG"))
+    {
+        double valor = 0.0;
+        if (num_tokens != 3)
+            return erro("uso: REG <registrador> <valor>");
+        int reg = tokenToRegisterIndex(tokens[1]);
+        if (reg < 0)
+            return erro("registrador inválido '" + tokens[1].str() + "'");
+        if (!tokenToDouble(tokens[2], valor))
+            return erro("valor inválido '" + tokens[2].str() + "'");
+        sim.valores_iniciais.push_back(std::make_pair(reg, (float)valor));
+        return true;
+    }
+
+    // Front-end: "FETCH_WIDTH", "DECODE_LATENCY", "IQ_SIZE", "ICACHE_LINES", "ICACHE_ASSOC",
+    // "ICACHE_LINE_SIZE", "ICACHE_MISS_LATENCY" (qualquer um deles liga o front-end)
+    if (chave.equals("FETCH_WIDTH") || chave.equals("DECODE_LATENCY") || chave.equals("IQ_SIZE") ||
+        chave.equals("ICACHE_LINES") || chave.equals("ICACHE_ASSOC") || chave.equals("ICACHE_LINE_SIZE") ||
+        chave.equals("ICACHE_MISS_LATENCY"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: " + chave.str() + " <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        sim.front_end = true;
+        if (chave.equals("FETCH_WIDTH"))
+            sim.fetch_width = n;
+        else if (chave.equals("DECODE_LATENCY"))
+            sim.decode_latency = n;
+        else if (chave.equals("IQ_SIZE"))
+            sim.iq_size = n;
+        else if (chave.equals("ICACHE_LINES"))
+            sim.icache.num_linhas = n;
+        else if (chave.equals("ICACHE_ASSOC"))
+            sim.icache.assoc = n;
+        else if (chave.equals("ICACHE_LINE_SIZE"))
+            sim.icache.tamanho_linha = n;
+        else
+            sim.icache_miss_latency = n;
+        return true;
+    }
+
+    // Cache de dados e prefetcher
+    if (chave.equals("DCACHE_LINES") || chave.equals("DCACHE_ASSOC") || chave.equals("DCACHE_LINE_SIZE") ||
+        chave.equals("MEM_LATENCY") || chave.equals("MEM_PORTS") || chave.equals("PREFETCH_DEGREE") ||
+        chave.equals("PREFETCH_DISTANCE"))
+    {
+        int n = 0;
+        if (num_tokens != 2)
+            return erro("uso: " + chave.str() + " <valor>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        if (chave.equals("DCACHE_LINES"))
+            sim.dcache.num_linhas = n;
+        else if (chave.equals("DCACHE_ASSOC"))
+            sim.dcache.assoc = n;
+        else if (chave.equals("DCACHE_LINE_SIZE"))
+            sim.dcache.tamanho_linha = n;
+        else if (chave.equals("MEM_LATENCY"))
+            sim.mem_latency = n;
+        else if (chave.equals("MEM_PORTS"))
+            sim.mem_ports = n;
+        else if (chave.equals("PREFETCH_DEGREE"))
+            sim.prefetch_degree = n;
+        else
+            sim.prefetch_distance = n;
+        return true;
+    }
+    if (chave.equals("PREFETCHER"))
+    {
+        if (num_tokens != 2)
+            return erro("uso: PREFETCHER NONE|NEXT_LINE|STRIDE|STREAM");
+        if (tokens[1].equals("NONE"))
+            sim.tipo_prefetcher = PF_NONE;
+        else if (tokens[1].equals("NEXT_LINE"))
+            sim.tipo_prefetcher = PF_NEXT_LINE;
+        else if (tokens[1].equals("STRIDE"))
+            sim.tipo_prefetcher = PF_STRIDE;
+        else if (tokens[1].equals("STREAM"))
+            sim.tipo_prefetcher = PF_STREAM;
+        else
+            return erro("prefetcher desconhecido '" + tokens[1].str() + "'");
+        return true;
+    }
+
+    // Modelo de energia: "ENERGY <EVENTO|STATIC> <pJ>", "CLOCK_GHZ <valor>"
+    if (chave.equals("ENERGY"))
+    {
+        double pj = 0.0;
+        if (num_tokens != 3)
+            return erro("uso: ENERGY <EVENTO> <pJ>");
+        if (!tokenToDouble(tokens[2], pj) || pj < 0.0)
+            return erro("energia inválida '" + tokens[2].str() + "'");
+        if (tokens[1].equals("STATIC"))
+        {
+            sim.energia_estatica_pj = pj;
+            return true;
+        }
+        for (int e = 0; e < NUM_EVENTOS; ++e)
+        {
+            if (tokens[1].equals(EventosInfo[e].nome))
+            {
+                sim.energia_pj[e] = pj;
+                return true;
+            }
+        }
+        return erro("evento de energia desconhecido '" + tokens[1].str() + "'");
+    }
+    if (chave.equals("CLOCK_GHZ"))
+    {
+        double ghz = 0.0;
+        if (num_tokens != 2 || !tokenToDouble(tokens[1], ghz) || ghz <= 0.0)
+            return erro("uso: CLOCK_GHZ <valor positivo>");
+        sim.clock_ghz = ghz;
+        return true;
+    }
+
+    // "CYCLES <OP> <VALOR>", "UNITS <OP> <VALOR>", "MEM_UNITS <OP> <VALOR>", "FUNC_UNITS <OP> <VALOR>"
+    bool is_cycles = chave.equals("CYCLES");
+    bool is_units = chave.equals("UNITS") || chave.equals("MEM_UNITS");
+    bool is_func = chave.equals("FUNC_UNITS");
+    if (!is_cycles && !is_units && !is_func)
+        return erro("parâmetro de configuração desconhecido '" + chave.str() + "'");
+    if (num_tokens != 3)
+        return erro("uso: " + chave.str() + " <OPERACAO> <valor>");
+
+    OpCode op = tokenToOpCode(tokens[1]);
+    if (op == UNKNOWN)
+        return erro("operação desconhecida '" + tokens[1].str() + "'");
+    int value = 0;
+    if (!lerInteiroPositivo(tokens[2], value))
+        return false;
+
+    if (is_cycles)
+    {
+        sim.cycle_times[op] = value;
+        return true;
+    }
+    if (is_func)
+    {
+        // Unidades não pipelinadas compartilhadas pelas estações da classe
+        if (op == ADD_D || op == SUB_D)
+            sim.unidades_add = value;
+        else if (op == MUL_D || op == DIV_D)
+            sim.unidades_mult = value;
+        else
+            return erro("FUNC_UNITS vale para ADDD/SUBD/MULTD/DIVD (loads disputam MEM_PORTS)");
+        return true;
+    }
+
+    ConjuntoRS &rs_set = sim.conjuntoDe(op);
+    for (int i = 0; i < value; ++i)
+        rs_set.emplace_back((int)rs_set.size() + 1);
+    sim.unit_counts[op] = value;
+    return true;
+}
+
+bool LeitorEntrada::lerInstrucao()
+{
+    FilaInstrucoes &fila = sim.threads.back().instruction_queue;
+
+    // Laço sem desvios: "REPEAT <n>" ... "END_REPEAT" repete o corpo n vezes, mantendo
+    // o PC estático de cada instrução (os preditores veem o mesmo PC a cada iteração)
+    if (tokens[0].equals("REPEAT"))
+    {
+        int n = 0;
+        if (em_repeat)
+            return erro("REPEAT aninhado não é suportado");
+        if (num_tokens != 2)
+            return erro("uso: REPEAT <vezes>");
+        if (!lerInteiroPositivo(tokens[1], n))
+            return false;
+        em_repeat = true;
+        inicio_repeat = fila.total();
+        repeticoes = n;
+        return true;
+    }
+    if (tokens[0].equals("END_REPEAT"))
+    {
+        if (!em_repeat)
+            return erro("END_REPEAT sem REPEAT");
+        if (num_tokens != 1)
+            return erro("conteúdo inesperado após END_REPEAT");
+        long long corpo = (long long)(fila.total() - inicio_repeat);
+        long long expandidas = (long long)inicio_repeat + corpo * repeticoes;
+        if (expandidas > MAX_INSTRUCOES_EXPANDIDAS)
+            return erro("REPEAT " + std::to_string(repeticoes) + " de " + std::to_string(corpo) +
+                        " instruções expande o programa para " + std::to_string(expandidas) +
+                        " instruções (limite: " + std::to_string(MAX_INSTRUCOES_EXPANDIDAS) + ")");
+        fila.repete(inicio_repeat, fila.total(), repeticoes - 1);
+        em_repeat = false;
+        return true;
+    }
+
+    OpCode op = tokenToOpCode(tokens[0]);
+    if (op == UNKNOWN)
+        return erro("operação desconhecida '" + tokens[0].str() + "'");
+
+    if (op == L_D || op == S_D)
+    {
+        // L.D F1, 8(R1)  -> tokens = {L.D, F1, 8, R1}
+        // S.D F2, 0(R1)  -> tokens = {S.D, F2, 0, R1}
+        // L.D F1, (R1)   -> tokens = {L.D, F1, R1} (deslocamento 0)
+        if (num_tokens != 3 && num_tokens != 4)
+            return erro("uso: " + tokens[0].str() + " Fd, deslocamento(Rs)");
+        int dest_reg = tokenToRegisterIndex(tokens[1]); // F1 (para L.D) ou F2 (para S.D)
+        if (dest_reg < 0)
+            return erro("registrador inválido '" + tokens[1].str() + "'");
+        long long imediato = 0;
+        if (num_tokens == 4 && !tokenToInt(tokens[2], imediato))
+            return erro("deslocamento inválido '" + tokens[2].str() + "'");
+        if (imediato < INT_MIN || imediato > INT_MAX)
+            return erro("deslocamento fora do intervalo [" + std::to_string(INT_MIN) + ", " +
+                        std::to_string(INT_MAX) + "]: '" + tokens[2].str() + "'");
+        const Token &base = tokens[num_tokens - 1];
+        int base_reg = tokenToRegisterIndex(base); // O registrador base (R1)
+        if (base_reg < 0)
+            return erro("registrador base inválido '" + base.str() + "'");
+        Instrucao inst(op, dest_reg, base_reg, -1, (int)imediato);
+        inst.pc = proximo_pc++;
+        fila.push_back(inst);
+        return true;
+    }
+
+    if (num_tokens != 4)
+        return erro("uso: " + tokens[0].str() + " Fd, Fs1, Fs2");
+    int regs[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        regs[i] = tokenToRegisterIndex(tokens[i + 1]);
+        if (regs[i] < 0)
+            return erro("registrador inválido '" + tokens[i + 1].str() + "'");
+    }
+    Instrucao inst(op, regs[0], regs[1], regs[2]);
+    inst.pc = proximo_pc++;
+    fila.push_back(inst);
+    return true;
+}
+
+bool LeitorEntrada::ler(const char *p, const char *fim)
+{
+    Secao secao = FORA;
+    bool viu_instrucoes = false;
+
+    while (p < fim)
+    {
+        const char *fim_linha = (const char *)std::memchr(p, '\n', (size_t)(fim - p));
+        if (fim_linha == nullptr)
+            fim_linha = fim;
+        linha++;
+
+        if (!tokenizar(p, fim_linha))
+            return false;
+        p = fim_linha + 1;
+
+        if (num_tokens == 0)
+            continue;
+        if (sim.calcula_assinatura)
+            sim.assinatura.adicionaLinha(tokens, num_tokens);
+
+        const Token &t = tokens[0];
+        if (t.equals("CONFIG_BEGIN") || t.equals("INSTRUCTIONS_BEGIN"))
+        {
+            if (secao != FORA)
+                return erro("'" + t.str() + "' dentro de outra seção");
+            if (num_tokens != 1)
+                return erro("conteúdo inesperado após '" + t.str() + "'");
+            if (t.equals("CONFIG_BEGIN") && viu_instrucoes)
+                return erro("CONFIG_BEGIN deve vir antes de INSTRUCTIONS_BEGIN");
+            secao = t.equals("CONFIG_BEGIN") ? CONFIG : INSTRUCOES;
+            viu_instrucoes = viu_instrucoes || secao == INSTRUCOES;
+            if (secao == INSTRUCOES)
+                sim.threads.emplace_back((int)sim.threads.size()); // Cada bloco é uma thread (SMT)
+            continue;
+        }
+        if (t.equals("CONFIG_END") || t.equals("INSTRUCTIONS_END"))
+        {
+            Secao esperada = t.equals("CONFIG_END") ? CONFIG : INSTRUCOES;
+            if (secao != esperada)
+                return erro("'" + t.str() + "' sem o BEGIN correspondente");
+            if (em_repeat)
+                return erro("REPEAT sem END_REPEAT");
+            secao = FORA;
+            continue;
+        }
+
+        bool ok = true;
+        if (secao == CONFIG)
+            ok = lerConfiguracao();
+        else if (secao == INSTRUCOES)
+            ok = lerInstrucao();
+        else
+            ok = erro("conteúdo fora de CONFIG_BEGIN/CONFIG_END e INSTRUCTIONS_BEGIN/INSTRUCTIONS_END");
+        if (!ok)
+            return false;
+    }
+
+    if (secao != FORA)
+        return erro(secao == CONFIG ? "CONFIG_END ausente" : "INSTRUCTIONS_END ausente");
+    return true;
+}
+
+bool TomasuloSimulator::loadInput(const std::string &path)
+{
+    ArquivoMapeado arquivo;
+    {
+        PROFILE_FASE(FASE_ABERTURA);
+        if (!arquivo.abrir(path))
+        {
+            std::cerr << "Erro: Não foi possível abrir o arquivo de entrada " << path << "\n";
+            return false;
+        }
+    }
+
+    LeitorEntrada leitor(*this, path);
+    {
+        PROFILE_FASE(FASE_LEITURA);
+        if (!leitor.ler(arquivo.begin(), arquivo.end()))
+            return false;
+    }
+    input_lines = leitor.linhasLidas();
+
+    PROFILE_FASE(FASE_VALIDACAO);
+
+    // Toda classe de instrução usada precisa de estação de reserva, senão o issue trava para sempre
+    bool precisa[UNKNOWN] = {false, false, false, false, false, false};
+    for (const auto &t : threads)
+        for (size_t i = 0; i < t.instruction_queue.size(); ++i)
+            precisa[t.instruction_queue[i].op] = true;
+    auto checa = [&](bool usada, const ConjuntoRS &rs_set, const char *config) {
+        if (usada && rs_set.empty())
+        {
+            std::cerr << path << ": erro: o programa usa " << config
+                      << " mas nenhuma estação de reserva foi configurada\n";
+            return false;
+        }
+        return true;
+    };
+    if (!(checa(precisa[ADD_D] || precisa[SUB_D], rs_add, "ADDD/SUBD (UNITS ADDD)") &&
+          checa(precisa[MUL_D] || precisa[DIV_D], rs_mult, "MULTD/DIVD (UNITS MULTD)") &&
+          checa(precisa[L_D], rs_load, "LD (MEM_UNITS LD)") &&
+          checa(precisa[S_D], rs_store, "SD (MEM_UNITS SD)")))
+        return false;
+
+    if (tipo_prefetcher != PF_NONE && !dcache.ativa())
+    {
+        std::cerr << path << ": erro: PREFETCHER requer uma cache de dados (DCACHE_LINES)\n";
+        return false;
+    }
+    // ROB: estático divide as entradas entre as threads; compartilhado deixa cada thread
+    // crescer até o total, limitado pela ocupação somada (verificada no issue)
+    int num_threads = std::max<int>(1, (int)threads.size());
+    if (rob_partition == ROB_STATIC && rob_size < num_threads)
+    {
+        std::cerr << path << ": erro: ROB_PARTITION STATIC precisa de ROB_SIZE >= número de threads ("
+                  << num_threads << ")\n";
+        return false;
+    }
+    // PRF: cada thread prende 32 físicos com o estado confirmado; sem nenhum a mais
+    // nenhuma instrução consegue despachar
+    if (phys_regs == 0)
+        phys_regs = NUM_FP_REGISTERS * num_threads + rob_size;
+    if (rename_mode == RENAME_PRF && phys_regs <= NUM_FP_REGISTERS * num_threads)
+    {
+        std::cerr << path << ": erro: PHYS_REGS precisa ser maior que " << NUM_FP_REGISTERS * num_threads
+                  << " (32 registradores arquiteturais por thread)\n";
+        return false;
+    }
+    // Índices globais das estações (para a matriz de idade)
+    rs_mult.base = (int)rs_add.size();
+    rs_load.base = rs_mult.base + (int)rs_mult.size();
+    rs_store.base = rs_load.base + (int)rs_load.size();
+    idade_rs.resize(rs_store.base + (int)rs_store.size());
+
+    tag_stride = (rob_partition == ROB_STATIC) ? rob_size / num_threads : rob_size;
+    for (auto &t : threads)
+    {
+        t.rob.resize(tag_stride);
+        t.tag_base = t.id * tag_stride;
+        t.total_instructions = (int)t.instruction_queue.size();
+    }
+
+    dcache.configura();
+    icache.configura();
+    if (fetch_width == 0)
+        fetch_width = issue_width;
+    prefetcher.reset(criaPrefetcher(tipo_prefetcher, prefetch_degree, prefetch_distance));
+    if (mem_ports == 0)
+        mem_ports = std::max<int>(1, (int)rs_load.size());
+    return true;
+}
+
+// --- FASES DE EXECUÇÃO ---
+
+int TomasuloSimulator::totalInstrucoes() const
+{
+    int total = 0;
+    for (const auto &t : threads)
+        total += (int)t.instruction_queue.total();
+    return total;
+}
+
+int TomasuloSimulator::robOcupacao() const
+{
+    int ocupadas = 0;
+    for (const auto &t : threads)
+        ocupadas += t.rob.ocupacao();
+    return ocupadas;
+}
+
+// Identificação da thread nas mensagens do trace; vazia com uma thread só
+std::string TomasuloSimulator::rotuloThread(const ContextoThread &t) const
+{
+    return (threads.size() > 1) ? " [T" + std::to_string(t.id) + "]" : "";
+}
+
+// Ordem em que as threads usam a largura de busca e de despacho neste ciclo, conforme a
+// FETCH_POLICY: rodízio a partir de proxima_thread, ou ICOUNT (menos instruções esperando
+// operandos nas RSs = maior prioridade; empates ficam na ordem do rodízio)
+std::vector<int> TomasuloSimulator::ordemThreads()
+{
+    int num_threads = (int)threads.size();
+    std::vector<int> ordem;
+    for (int k = 0; k < num_threads; ++k)
+        ordem.push_back((proxima_thread + k) % num_threads);
+    if (fetch_policy == FETCH_ICOUNT && num_threads > 1)
+    {
+        std::vector<int> esperando(num_threads, 0);
+        for (auto *rs_set : {&rs_add, &rs_mult, &rs_load, &rs_store})
+            for (const auto &rs : *rs_set)
+                if (rs.ocupado && robEntry(rs.Dest).estado == Issue)
+                    esperando[threadDaTag(rs.Dest).id]++;
+        std::stable_sort(ordem.begin(), ordem.end(),
+                         [&](int a, int b) { return esperando[a] < esperando[b]; });
+    }
+    return ordem;
+}
+
+void TomasuloSimulator::issue()
+{
+    PROFILE_FASE(FASE_ISSUE);
+    // Despacho superescalar em ordem: até issue_width instruções por ciclo.
+    // O grupo para na primeira instrução que não puder ser despachada (stall),
+    // e a renomeação é feita instrução a instrução, então uma instrução do grupo
+    // já enxerga no ModoRegistrador as tags das anteriores do mesmo grupo.
+    // Com várias threads a largura é compartilhada: as threads são visitadas na ordem
+    // da FETCH_POLICY e as vagas que uma thread em stall deixa passam para a próxima.
+    int despachadas = 0;
+    for (int id : ordemThreads())
+        while (despachadas < issue_width && issueOne(threads[id]))
+            despachadas++;
+
+    // Vagas sobrando: faltou instrução decodificada (front-end) ou recurso no back end
+    if (front_end && despachadas < issue_width)
+    {
+        bool pronta = false, restante = false;
+        for (const auto &t : threads)
+        {
+            pronta = pronta || temInstrucao(t);
+            restante = restante || !t.fila_decodificada.empty() || !t.instruction_queue.empty();
+        }
+        if (pronta)
+            ciclos_issue_saturado++;
+        else if (restante)
+        {
+            ciclos_issue_faminto++;
+            vagas_issue_famintas += issue_width - despachadas;
+        }
+    }
+
+    if ((int)issue_histogram.size() < issue_width + 1)
+        issue_histogram.resize(issue_width + 1, 0);
+    issue_histogram[despachadas]++;
+}
+
+// Há instrução para o issue: a próxima do programa (busca ideal) ou uma decodificada pronta
+bool TomasuloSimulator::temInstrucao(const ContextoThread &t) const
+{
+    if (!front_end)
+        return !t.instruction_queue.empty();
+    return !t.fila_decodificada.empty() && t.fila_decodificada.front().pronta_ciclo <= clock_cycle;
+}
+
+// Front-end: busca até fetch_width instruções por ciclo, dividido entre as threads na
+// ordem da FETCH_POLICY, a mesma do issue (a largura que uma thread parada não usa passa
+// adiante). As buscadas ficam prontas para o issue depois de decode_latency ciclos.
+void TomasuloSimulator::fetch()
+{
+    PROFILE_FASE(FASE_FETCH);
+    int buscadas = 0;
+    for (int id : ordemThreads())
+    {
+        if (buscadas >= fetch_width)
+            break;
+        fetchThread(threads[id], buscadas);
+    }
+}
+
+void TomasuloSimulator::fetchThread(ContextoThread &t, int &buscadas)
+{
+    if (t.instruction_queue.empty())
+        return;
+    if (t.fetch_parado_ate > clock_cycle)
+    {
+        ciclos_fetch_icache++;
+        return;
+    }
+    while (buscadas < fetch_width && !t.instruction_queue.empty())
+    {
+        if ((int)t.fila_decodificada.size() >= iq_size)
+        {
+            ciclos_fetch_fila_cheia++;
+            return;
+        }
+        const Instrucao &inst = t.instruction_queue.front();
+        if (icache.ativa())
+        {
+            // Uma consulta por instrução; a linha chegando (falta ou busca anterior) para a busca
+            long long linha = icache.linhaDe((long long)inst.pc * BYTES_INSTRUCAO);
+            CacheDados::Linha *l = icache.procura(linha);
+            if (l == nullptr)
+            {
+                icache_faltas++;
+                CacheDados::Linha despejada;
+                l = &icache.aloca(linha, clock_cycle + icache_miss_latency, false, despejada);
+                std::cout << "  > FETCH" << rotuloThread(t) << ": falta na cache de instruções (PC " << inst.pc
+                          << "), busca parada até o ciclo " << l->pronta_ciclo << "\n";
+            }
+            if (l->pronta_ciclo > clock_cycle)
+            {
+                t.fetch_parado_ate = (int)l->pronta_ciclo;
+                t.refaz_falta = true;
+                ciclos_fetch_icache++;
+                return;
+            }
+            if (!t.refaz_falta)
+                icache_acertos++;
+            t.refaz_falta = false;
+        }
+        t.fila_decodificada.push_back({inst, clock_cycle + decode_latency});
+        t.instruction_queue.pop_front();
+        instrucoes_buscadas++;
+        buscadas++;
+    }
+}
+
+bool TomasuloSimulator::issueOne(ContextoThread &t)
+{
+    if (!temInstrucao(t) || t.rob.isFull() || robOcupacao() >= rob_size)
+        return false;
+
+    Instrucao current_inst = front_end ? t.fila_decodificada.front().inst : t.instruction_queue.front();
+
+    // Estação livre da classe, achada pela máscara de livres do conjunto
+    ConjuntoRS &rs_set = conjuntoDe(current_inst.op);
+    int livre = rs_set.aloca();
+    EstacaoReserva *target_rs = (livre < 0) ? nullptr : &rs_set[livre];
+
+    if (target_rs == nullptr)
+        return false; // Stall: RS cheia
+
+    // Modo PRF: todo resultado precisa de um registrador físico livre
+    bool precisa_fisico = modoPRF() && current_inst.op != S_D;
+    if (precisa_fisico && prf.disponiveis() == 0)
+    {
+        rs_set.libera(*target_rs);
+        stalls_registrador_fisico++;
+        return false; // Stall: lista livre vazia
+    }
+
+    // Previsão de valor do load: instâncias do mesmo PC ainda no ROB contam como
+    // iterações em voo (o preditor só é treinado no commit)
+    int em_voo = 0;
+    if (current_inst.op == L_D && preditor_valor.ativo() && !t.rob.isEmpty())
+    {
+        for (int tag = t.headTag(); tag != 0; tag = t.youngerTag(tag))
+        {
+            const ROB_Entry &entry = t.getEntry(tag);
+            if (entry.ocupado && entry.op == L_D && entry.pc == current_inst.pc)
+                em_voo++;
+        }
+    }
+
+    int rob_tag = t.rob.issue(current_inst) + t.tag_base;
+    conta(EV_ROB_WRITE);
+    conta(EV_RS_WRITE);
+
+    if (current_inst.op == L_D && preditor_valor.ativo())
+    {
+        ROB_Entry &load = t.getEntry(rob_tag);
+        conta(EV_VPT);
+        if (preditor_valor.prediz(current_inst.pc, em_voo, load.valor_previsto))
+        {
+            load.previsto = true;
+            load.fez_previsao = true;
+        }
+    }
+
+    // Leitura de operando: se o registrador tem produtor em voo, espera a tag;
+    // se o produtor já transmitiu no CDB (resultado no ROB aguardando commit),
+    // lê o valor direto do ROB para não esperar um broadcast que já passou.
+    auto read_operand = [&](int reg, float &V, int &Q) {
+        int tag = t.reg_status.getTag(reg);
+        conta(EV_RAT_READ);
+        if (modoPRF())
+        {
+            // O mapa dá o físico; pronto = já transmitido (ou valor confirmado)
+            int p = t.mapa[reg];
+            if (prf.pronto[p])
+            {
+                V = prf.valores[p];
+                Q = 0;
+                conta(EV_RF_READ);
+                return;
+            }
+            ROB_Entry &producer = t.getEntry(tag);
+            if (producer.previsto)
+            {
+                V = producer.valor_previsto;
+                Q = 0;
+                if (producer.consumidor_seq == -1)
+                    producer.consumidor_seq = t.getEntry(rob_tag).seq;
+                vp_consumos++;
+                conta(EV_ROB_READ);
+            }
+            else
+            {
+                Q = p + 1;
+            }
+            return;
+        }
+        if (tag != 0)
+        {
+            ROB_Entry &producer = t.getEntry(tag);
+            if (producer.transmitido)
+            {
+                V = producer.valor;
+                Q = 0;
+                conta(EV_ROB_READ);
+            }
+            else if (producer.previsto)
+            {
+                // Load com valor previsto: o dependente sai com o valor agora e é
+                // descartado se a verificação no fim do load encontrar outro valor
+                V = producer.valor_previsto;
+                Q = 0;
+                if (producer.consumidor_seq == -1)
+                    producer.consumidor_seq = t.getEntry(rob_tag).seq;
+                vp_consumos++;
+                conta(EV_ROB_READ);
+            }
+            else
+            {
+                Q = tag;
+            }
+        }
+        else
+        {
+            // Assume que registradores R (integer) estão em fp_registers_values (simplificação do seu código)
+            V = t.fp_registers_values[reg];
+            Q = 0;
+            conta(EV_RF_READ);
+        }
+    };
+
+    target_rs->clear();
+    target_rs->ocupado = true;
+    idade_rs.aloca(rs_set.base + livre);
+    target_rs->op = current_inst.op;
+    target_rs->Dest = rob_tag;
+    if (current_inst.op == L_D || current_inst.op == S_D)
+        target_rs->A = current_inst.imediato; // Deslocamento; vira o endereço efetivo no execute
+
+    // Renomeação do Fonte 1:
+    // (Para Arith: src1. Para L/S: registrador base R1)
+    if (current_inst.src1_reg != -1)
+    {
+        read_operand(current_inst.src1_reg, target_rs->Vj, target_rs->Qj);
+    }
+
+    // Renomeação do Fonte 2 (Apenas para Arith e Store)
+    if (current_inst.op == ADD_D || current_inst.op == SUB_D || current_inst.op == MUL_D || current_inst.op == DIV_D)
+    {
+        // Fonte 2 (Arith)
+        read_operand(current_inst.src2_reg, target_rs->Vk, target_rs->Qk);
+    }
+    else if (current_inst.op == S_D)
+    {
+        // Fonte 2 (Store) -> É o *valor* (F2 em S.D F2, 0(R1))
+        // O parser salvou F2 em 'dest_reg'
+        read_operand(current_inst.dest_reg, target_rs->Vk, target_rs->Qk);
+    }
+
+    // Atualiza o Status do Registrador Destino
+    // (S.D não atualiza o status, pois não escreve em registrador)
+    if (current_inst.op != S_D && current_inst.dest_reg != -1)
+    {
+        t.reg_status.setTag(current_inst.dest_reg, rob_tag);
+        conta(EV_RAT_WRITE);
+    }
+    if (precisa_fisico)
+    {
+        ROB_Entry &entry = t.getEntry(rob_tag);
+        entry.preg = prf.aloca();
+        if (current_inst.dest_reg != -1)
+        {
+            entry.preg_antigo = t.mapa[current_inst.dest_reg];
+            t.mapa[current_inst.dest_reg] = entry.preg;
+        }
+    }
+
+    if (front_end)
+        t.fila_decodificada.pop_front();
+    else
+        t.instruction_queue.pop_front();
+    std::cout << "  > ISSUED" << rotuloThread(t) << ": " << current_inst.getOpName()
+              << " (Dest ROB Tag: " << rob_tag << ")\n";
+    return true;
+}
+
+// Desambiguação de um load: percorre os stores mais velhos do mais novo para o mais velho.
+// O primeiro store com o mesmo endereço fornece o valor (forwarding) se o dado já estiver
+// pronto; um store sem endereço segura o load conforme a política MEM_DEP.
+bool TomasuloSimulator::loadPodeAcessar(int load_tag, float &valor)
+{
+    // Só os stores da própria thread: entre threads a comunicação é pela memória confirmada
+    ContextoThread &t = threadDaTag(load_tag);
+    ROB_Entry &load = t.getEntry(load_tag);
+    bool passou_store_sem_endereco = false;
+
+    for (int tag = t.olderTag(load_tag); tag != 0; tag = t.olderTag(tag))
+    {
+        ROB_Entry &store = t.getEntry(tag);
+        conta(EV_ROB_READ);
+        if (!store.ocupado || store.op != S_D)
+            continue;
+
+        if (!store.enderecocerto)
+        {
+            if (mem_dep == MEMDEP_CONSERVATIVE)
+                return false;
+            if (mem_dep == MEMDEP_STORE_SETS && store_sets.prediz(load.pc, store.pc))
+            {
+                if (!load.retido_preditor)
+                    loads_retidos_preditor++;
+                load.retido_preditor = true;
+                return false;
+            }
+            passou_store_sem_endereco = true;
+            continue;
+        }
+
+        if (store.enderecoMemoria == load.enderecoMemoria)
+        {
+            if (store.estado != escreveresult)
+                return false; // Endereço igual, mas o dado do store ainda não chegou
+            valor = store.valor;
+            load.fonte_seq = store.seq;
+            loads_forwarding++;
+            break;
+        }
+    }
+
+    if (load.fonte_seq == -1)
+    {
+        if (!dcache.ativa())
+            conta(EV_MEM_READ); // Com cache, só os preenchimentos acessam a memória
+        auto it = memoria.find(load.enderecoMemoria);
+        valor = (it != memoria.end()) ? it->second : VALOR_MEMORIA_PADRAO;
+    }
+    if (passou_store_sem_endereco)
+    {
+        load.especulativo = true;
+        loads_especulativos++;
+    }
+    return true;
+}
+
+// Acesso de demanda de um load à cache de dados. Devolve os ciclos além de CYCLES LD:
+// 0 num acerto, o que falta para o preenchimento num acerto em linha ainda chegando,
+// e MEM_LATENCY numa falta. Também alimenta o prefetcher com o acesso.
+int TomasuloSimulator::acessaCache(int pc, long long endereco)
+{
+    long long linha = dcache.linhaDe(endereco);
+    CacheDados::Linha *l = dcache.procura(linha);
+    conta(EV_DCACHE);
+
+    int extra = 0;
+    bool falta = (l == nullptr);
+    if (falta)
+    {
+        dcache_faltas++;
+        conta(EV_MEM_READ);
+        CacheDados::Linha despejada;
+        dcache.aloca(linha, clock_cycle + mem_latency, false, despejada);
+        if (despejada.valida && despejada.prefetch)
+            prefetches_inuteis++;
+        extra = mem_latency;
+    }
+    else
+    {
+        dcache_acertos++;
+        if (l->pronta_ciclo > clock_cycle)
+            extra = (int)(l->pronta_ciclo - clock_cycle);
+        if (l->prefetch)
+        {
+            prefetches_uteis++;
+            if (extra > 0)
+                prefetches_tardios++;
+            l->prefetch = false;
+        }
+    }
+
+    if (prefetcher)
+    {
+        std::vector<long long> candidatas;
+        prefetcher->observa(pc, linha, falta, candidatas);
+        for (long long c : candidatas)
+        {
+            if (std::find(fila_prefetch.begin(), fila_prefetch.end(), c) != fila_prefetch.end())
+                continue;
+            if ((int)fila_prefetch.size() == PREFETCH_QUEUE_SIZE)
+            {
+                fila_prefetch.pop_front();
+                prefetches_descartados++;
+            }
+            fila_prefetch.push_back(c);
+        }
+    }
+    return extra;
+}
+
+// Prefetches usam as portas de memória que os loads de demanda deixaram livres no ciclo
+void TomasuloSimulator::emitePrefetches()
+{
+    while (portas_livres > 0 && !fila_prefetch.empty())
+    {
+        long long linha = fila_prefetch.front();
+        fila_prefetch.pop_front();
+        if (dcache.procura(linha) != nullptr)
+            continue; // Já está (ou já está chegando) na cache
+
+        CacheDados::Linha despejada;
+        dcache.aloca(linha, clock_cycle + mem_latency, true, despejada);
+        if (despejada.valida && despejada.prefetch)
+            prefetches_inuteis++;
+        prefetches_emitidos++;
+        portas_livres--;
+        conta(EV_MEM_READ);
+        conta(EV_DCACHE);
     }
+}
 
-    if (target_rs == nullptr)
-        return; // Stall: RS cheia
+// Um store acabou de resolver o endereço: qualquer load mais novo que já leu esse endereço
+// de uma fonte mais velha que o store (memória ou store anterior) violou a dependência.
+// O load mais velho nessa situação é descartado junto com tudo que veio depois e rebuscado.
+void TomasuloSimulator::checkMemoryViolation(int store_tag)
+{
+    ContextoThread &t = threadDaTag(store_tag);
+    ROB_Entry &store = t.getEntry(store_tag);
 
-    int rob_tag = rob.issue(current_inst);
+    for (int tag = t.youngerTag(store_tag); tag != 0; tag = t.youngerTag(tag))
+    {
+        ROB_Entry &load = t.getEntry(tag);
+        conta(EV_ROB_READ);
+        if (!load.ocupado || load.op != L_D || !load.acessou_memoria)
+            continue;
+        if (load.enderecoMemoria != store.enderecoMemoria || load.fonte_seq > store.seq)
+            continue;
 
-    target_rs->clear();
-    target_rs->ocupado = true;
-    target_rs->op = current_inst.op;
-    target_rs->Dest = rob_tag;
+        violacoes_memoria++;
+        if (mem_dep == MEMDEP_STORE_SETS)
+            store_sets.treinar(load.pc, store.pc);
+        std::cout << "  > VIOLAÇÃO DE MEMÓRIA: Load (Tag: " << tag << ") leu Mem[" << load.enderecoMemoria
+                  << "] antes do Store (Tag: " << store_tag << "). Descartando a partir do load.\n";
+        squash(tag);
+        return;
+    }
+}
 
-    // Renomeação do Fonte 1:
-    // (Para Arith: src1. Para L/S: registrador base R1)
-    if (current_inst.src1_reg != -1)
+// O load terminou com o valor real: compara com a previsão feita no issue. Numa previsão
+// errada já consumida, descarta a partir do consumidor mais velho (ele e tudo depois são
+// despachados de novo lendo o valor real); o próprio load segue com o valor certo.
+void TomasuloSimulator::verificaPrevisao(int load_tag)
+{
+    ContextoThread &t = threadDaTag(load_tag);
+    ROB_Entry &load = t.getEntry(load_tag);
+    if (!load.previsto)
+        return;
+    load.previsto = false; // Daqui em diante os consumidores esperam o valor real
+
+    load.previsao_correta = (load.valor_previsto == resultado(load));
+    if (load.previsao_correta)
+        return;
+    if (load.consumidor_seq == -1)
+        return; // Ninguém usou o valor errado
+
+    int tag = t.youngerTag(load_tag);
+    while (tag != 0 && t.getEntry(tag).seq < load.consumidor_seq)
+        tag = t.youngerTag(tag);
+    if (tag == 0)
+        return; // Consumidores já descartados por outro squash
+
+    std::cout << "  > VALOR PREVISTO ERRADO: Load (Tag: " << load_tag << ") previu " << load.valor_previsto
+              << " e leu " << resultado(load) << ". Descartando a partir da Tag " << tag << ".\n";
+    long long descartadas_antes = instrucoes_descartadas;
+    squash(tag);
+    vp_recuperacoes++;
+    vp_descartadas += instrucoes_descartadas - descartadas_antes;
+}
+
+// Descarta rob_tag e todas as instruções mais novas: libera as RSs delas, reconstrói o
+// status dos registradores a partir das entradas que sobraram e volta a busca para
+// a primeira instrução descartada, que será despachada de novo.
+void TomasuloSimulator::squash(int rob_tag)
+{
+    // Só a thread dona de rob_tag perde instruções; as outras seguem normalmente
+    ContextoThread &thread = threadDaTag(rob_tag);
+    long long indice_retorno = thread.getEntry(rob_tag).indice;
+
+    auto descartada = [&](int tag) {
+        for (int t = rob_tag; t != 0; t = thread.youngerTag(t))
+            if (t == tag)
+                return true;
+        return false;
+    };
+    for (auto *rs_set : {&rs_add, &rs_mult, &rs_load, &rs_store})
     {
-        int qj_tag = reg_status.getTag(current_inst.src1_reg);
-        if (qj_tag != 0)
-        {
-            target_rs->Qj = qj_tag;
-        }
-        else
+        for (auto &rs : *rs_set)
         {
-            // Assume que registradores R (integer) estão em fp_registers_values (simplificação do seu código)
-            target_rs->Vj = fp_registers_values[current_inst.src1_reg];
-            target_rs->Qj = 0;
+            if (rs.ocupado && descartada(rs.Dest))
+                liberaRS(rs);
         }
     }
 
-    // Renomeação do Fonte 2 (Apenas para Arith e Store)
-    if (current_inst.op == ADD_D || current_inst.op == SUB_D || current_inst.op == MUL_D || current_inst.op == DIV_D)
+    // Modo PRF: os físicos das descartadas voltam para a lista livre
+    if (modoPRF())
     {
-        // Fonte 2 (Arith)
-        int qk_tag = reg_status.getTag(current_inst.src2_reg);
-        if (qk_tag != 0)
+        for (int tag = rob_tag; tag != 0; tag = thread.youngerTag(tag))
         {
-            target_rs->Qk = qk_tag;
-        }
-        else
-        {
-            target_rs->Vk = fp_registers_values[current_inst.src2_reg];
-            target_rs->Qk = 0;
+            ROB_Entry &entry = thread.getEntry(tag);
+            if (entry.ocupado && entry.preg >= 0)
+                prf.libera(entry.preg);
         }
     }
-    else if (current_inst.op == S_D)
+
+    instrucoes_descartadas += thread.rob.squashFrom(rob_tag - thread.tag_base);
+
+    // O mapa especulativo volta ao confirmado e é refeito com as entradas que sobraram
+    thread.reg_status.reset();
+    if (modoPRF())
+        thread.mapa = thread.mapa_commit;
+    if (!thread.rob.isEmpty())
     {
-        // Fonte 2 (Store) -> É o *valor* (F2 em S.D F2, 0(R1))
-        // O parser salvou F2 em 'dest_reg'
-        int qk_tag = reg_status.getTag(current_inst.dest_reg);
-        if (qk_tag != 0)
+        for (int tag = thread.headTag(); tag != 0; tag = thread.youngerTag(tag))
         {
-            target_rs->Qk = qk_tag;
-        }
-        else
-        {
-            target_rs->Vk = fp_registers_values[current_inst.dest_reg];
-            target_rs->Qk = 0;
+            ROB_Entry &entry = thread.getEntry(tag);
+            if (entry.ocupado && entry.op != S_D && entry.reddestido != -1)
+            {
+                thread.reg_status.setTag(entry.reddestido, tag);
+                if (modoPRF())
+                    thread.mapa[entry.reddestido] = entry.preg;
+            }
         }
     }
 
-    // Atualiza o Status do Registrador Destino
-    // (S.D não atualiza o status, pois não escreve em registrador)
-    if (current_inst.op != S_D && current_inst.dest_reg != -1)
+    thread.instruction_queue.redirect(indice_retorno);
+    // Tudo na fila de decodificadas é mais novo que a instrução descartada
+    instrucoes_descartadas_fila += (long long)thread.fila_decodificada.size();
+    thread.fila_decodificada.clear();
+    thread.fetch_parado_ate = 0;
+    thread.refaz_falta = false;
+}
+
+// Divide [0, num_rs) em faixas contíguas, uma por parte, e chama f em cada uma. Com uma
+// parte só roda direto na thread do simulador, escrevendo no std::cout
+void TomasuloSimulator::varre(size_t num_rs, std::vector<ParteVarredura> &partes,
+                              const std::function<void(ParteVarredura &, size_t, size_t)> &f)
+{
+    int n = (int)partes.size();
+    if (n == 1)
     {
-        reg_status.setTag(current_inst.dest_reg, rob_tag);
+        partes[0].log = &std::cout;
+        f(partes[0], 0, num_rs);
+        return;
     }
+    for (auto &parte : partes)
+        parte.buffer.copyfmt(std::cout); // Mesmo formato numérico do trace
+    pool->executa(n, [&](int k) { f(partes[k], num_rs * k / n, num_rs * (k + 1) / n); });
+}
 
-    instruction_queue.pop();
-    std::cout << "  > ISSUED: " << current_inst.getOpName() << " (Dest ROB Tag: " << rob_tag << ")\n";
+// Junta as partes na ordem das faixas: trace e contadores saem iguais aos da execução serial
+void TomasuloSimulator::juntaPartes(std::vector<ParteVarredura> &partes)
+{
+    for (auto &parte : partes)
+    {
+        if (parte.log != &std::cout)
+            std::cout << parte.buffer.str();
+        for (int e = 0; e < NUM_EVENTOS; ++e)
+            atividade[e] += parte.atividade[e];
+    }
 }
 
-void TomasuloSimulator::execute()
+// Estágio de seleção: ordena as candidatas pela SELECT_POLICY (vencedoras primeiro)
+void TomasuloSimulator::ordenaSelecao(std::vector<EstacaoReserva *> &candidatas)
 {
+    if (select_policy == SEL_OLDEST)
+        std::sort(candidatas.begin(), candidatas.end(), [&](EstacaoReserva *a, EstacaoReserva *b) {
+            return idade_rs.maisVelha(indiceGlobal(*a), indiceGlobal(*b));
+        });
+    else if (select_policy == SEL_RANDOM)
+        std::shuffle(candidatas.begin(), candidatas.end(), rng_selecao);
+    else
+        std::sort(candidatas.begin(), candidatas.end(), [&](EstacaoReserva *a, EstacaoReserva *b) {
+            return indiceGlobal(*a) < indiceGlobal(*b);
+        });
+}
 
-    // Lógica para operações aritméticas (ADD/SUB/MUL/DIV)
-    auto process_arith_rs = [&](std::vector<EstacaoReserva> &rs_set) {
-        for (auto &rs : rs_set)
-        {
-            if (!rs.ocupado || rs.op == L_D || rs.op == S_D) continue;
+// Mantém só as 'limite' candidatas vencedoras (limite < 0 = todas); as perdedoras
+// continuam prontas e disputam de novo no próximo ciclo
+void TomasuloSimulator::seleciona(std::vector<EstacaoReserva *> &candidatas, int limite)
+{
+    if (limite < 0 || (int)candidatas.size() <= limite)
+        return;
+    selecao_disputas++;
+    selecao_adiadas += (long long)candidatas.size() - limite;
+    ordenaSelecao(candidatas);
+    candidatas.resize(limite);
+}
 
-            if (rs.Qj == 0 && rs.Qk == 0) // Ambos operandos prontos
+void TomasuloSimulator::execute()
+{
+    PROFILE_FASE(FASE_EXECUTE);
+    // Seleção de quem inicia neste ciclo; 'selecionadas' guarda as vencedoras
+
+    // Lógica para operações aritméticas (ADD/SUB/MUL/DIV). As duas varreduras são
+    // divididas em partes pelo --host-threads: cada estação só mexe em si e na própria
+    // entrada do ROB, e as partes são juntadas em ordem de posição
+    auto process_arith_rs = [&](ConjuntoRS &rs_set, int unidades) {
+        // Unidades não pipelinadas: as livres vão para as prontas escolhidas pela seleção
+        std::vector<ParteVarredura> &partes = partesPara(rs_set.size());
+        varre(rs_set.size(), partes, [&](ParteVarredura &parte, size_t inicio, size_t fim) {
+            for (size_t i = inicio; i < fim; ++i)
             {
-                ROB_Entry &rob_entry = rob.getEntry(rs.Dest);
-
-                if (rob_entry.estado == Issue)
-                { // Inicia execução
-                    rs.ciclosfaltantes = cycle_times[rs.op] - 1;
-                    rob_entry.estado = executando;
-                }
-                else if (rob_entry.estado == executando)
-                { // Continua execução
-                    if (rs.ciclosfaltantes > 0)
-                    {
-                        rs.ciclosfaltantes--;
-                    }
-                }
-
-                // FINAL DA EXECUÇÃO (CORREÇÃO DE LÓGICA DE CÁLCULO)
-                if (rs.ciclosfaltantes == 0 && rob_entry.estado == executando)
-                {
-                    // **CORREÇÃO: O cálculo DEVE ocorrer aqui, no final da execução.**
-                    float result = 0.0;
-                    if (rs.op == ADD_D)
-                        result = rs.Vj + rs.Vk;
-                    else if (rs.op == SUB_D)
-                        result = rs.Vj - rs.Vk;
-                    else if (rs.op == MUL_D)
-                        result = rs.Vj * rs.Vk;
-                    else if (rs.op == DIV_D)
-                        result = (rs.Vk != 0) ? (rs.Vj / rs.Vk) : 0.0;
-
-                    // Armazena o resultado no ROB
-                    rob_entry.valor = result;
-                    rob_entry.estado = escreveresult;
-                    
-                    std::cout << "  > EXECUTED: " << Instrucao(rs.op, -1, -1, -1).getOpName()
-                              << " (Tag: " << rs.Dest << ") - Resultado (" << result << ") pronto.\n";
-                }
+                EstacaoReserva &rs = rs_set[i];
+                if (!rs.ocupado || rs.Qj != 0 || rs.Qk != 0)
+                    continue;
+                ROBestado estado = robEntry(rs.Dest).estado;
+                if (estado == executando)
+                    parte.ocupadas++;
+                else if (estado == Issue)
+                    parte.estacoes.push_back(&rs);
             }
-        }
-    };
-
-    // --- Lógica para Operações de L.D (Load) ---
-    auto process_load_rs = [&](std::vector<EstacaoReserva> &rs_set) {
-        for (auto &rs : rs_set)
+        });
+        selecionadas.clear();
+        int ocupadas = 0;
+        for (auto &parte : partes)
         {
-            if (rs.ocupado && rs.op == L_D)
+            selecionadas.insert(selecionadas.end(), parte.estacoes.begin(), parte.estacoes.end());
+            ocupadas += parte.ocupadas;
+        }
+        seleciona(selecionadas, unidades > 0 ? std::max(0, unidades - ocupadas) : -1);
+        for (auto *rs : selecionadas)
+            rs->selecionada = true;
+
+        std::vector<ParteVarredura> &andamento = partesPara(rs_set.size());
+        varre(rs_set.size(), andamento, [&](ParteVarredura &parte, size_t inicio, size_t fim) {
+            std::ostream &log = *parte.log;
+            for (size_t i = inicio; i < fim; ++i)
             {
-                ROB_Entry &rob_entry = rob.getEntry(rs.Dest);
+                EstacaoReserva &rs = rs_set[i];
+                if (!rs.ocupado || rs.op == L_D || rs.op == S_D) continue;
 
-                // Load só pode iniciar se R1 (src1_reg/Vj) estiver pronto (Qj=0)
-                if (rs.Qj == 0)
+                if (rs.Qj == 0 && rs.Qk == 0) // Ambos operandos prontos
                 {
+                    ROB_Entry &rob_entry = robEntry(rs.Dest);
+
                     if (rob_entry.estado == Issue)
-                    { // Inicia execução (Cálculo de Endereço/Acesso à Memória)
-                        rs.ciclosfaltantes = cycle_times[rs.op] - 1;
+                    { // Inicia execução (se venceu a seleção)
+                        if (!rs.selecionada)
+                            continue;
+                        rs.ciclosfaltantes = cycle_times.at(rs.op) - 1;
                         rob_entry.estado = executando;
-
-                        // Simulação de cálculo de endereço (Placeholder)
-                        rob_entry.enderecocerto = true;
+                        parte.conta(eventoFU(rs.op));
                     }
                     else if (rob_entry.estado == executando)
                     { // Continua execução
@@ -569,70 +3067,196 @@ void TomasuloSimulator::execute()
                         }
                     }
 
-                    // Final da Execução (Acesso à memória concluído)
+                    // FINAL DA EXECUÇÃO (CORREÇÃO DE LÓGICA DE CÁLCULO)
                     if (rs.ciclosfaltantes == 0 && rob_entry.estado == executando)
                     {
-                        // **NOTA:** Aqui assumimos um valor fixo 99.0 para simular a leitura da memória.
-                        rob_entry.valor = 99.0; 
+                        // **CORREÇÃO: O cálculo DEVE ocorrer aqui, no final da execução.**
+                        float result = 0.0;
+                        if (rs.op == ADD_D)
+                            result = rs.Vj + rs.Vk;
+                        else if (rs.op == SUB_D)
+                            result = rs.Vj - rs.Vk;
+                        else if (rs.op == MUL_D)
+                            result = rs.Vj * rs.Vk;
+                        else if (rs.op == DIV_D)
+                            result = (rs.Vk != 0) ? (rs.Vj / rs.Vk) : 0.0;
+
+                        // Armazena o resultado no ROB (ou no registrador físico, modo PRF)
+                        resultado(rob_entry) = result;
                         rob_entry.estado = escreveresult;
-                        std::cout << "  > EXECUTED (LOAD): " << Instrucao(rs.op, -1, -1, -1).getOpName()
-                                  << " (Tag: " << rs.Dest << ") - Resultado pronto.\n";
+                        parte.conta(modoPRF() ? EV_RF_WRITE : EV_ROB_WRITE);
+
+                        log << "  > EXECUTED: " << Instrucao(rs.op, -1, -1, -1).getOpName()
+                            << " (Tag: " << rs.Dest << ") - Resultado (" << result << ") pronto.\n";
                     }
                 }
             }
+        });
+        juntaPartes(andamento);
+        for (auto *rs : selecionadas)
+            rs->selecionada = false;
+    };
+
+    // --- Lógica para Operações de L.D (Load) ---
+    auto process_load_rs = [&](ConjuntoRS &rs_set) {
+        // 1. Cálculo de endereço dos loads prontos; todos viram candidatos às portas de memória
+        selecionadas.clear();
+        for (auto &rs : rs_set)
+        {
+            if (!rs.ocupado || rs.op != L_D || rs.Qj != 0) // Load só pode iniciar se R1 (Vj) estiver pronto
+                continue;
+            ROB_Entry &rob_entry = robEntry(rs.Dest);
+            if (rob_entry.estado != Issue)
+                continue;
+            if (!rob_entry.enderecocerto)
+            {
+                rs.A = (long long)rs.Vj + rs.A;
+                rob_entry.enderecoMemoria = rs.A;
+                rob_entry.enderecocerto = true;
+                conta(EV_FU_LD);
+            }
+            selecionadas.push_back(&rs);
+        }
+
+        // 2. As portas livres vão para os candidatos na ordem da seleção; um load retido
+        // pela desambiguação não gasta porta e passa a vez para o seguinte
+        if ((int)selecionadas.size() > portas_livres)
+        {
+            selecao_disputas++;
+            ordenaSelecao(selecionadas);
+        }
+        std::vector<EstacaoReserva *> iniciados;
+        for (size_t k = 0; k < selecionadas.size(); ++k)
+        {
+            EstacaoReserva &rs = *selecionadas[k];
+            if (portas_livres == 0)
+            {
+                selecao_adiadas += (long long)(selecionadas.size() - k); // Todas as portas ocupadas neste ciclo
+                break;
+            }
+            ROB_Entry &rob_entry = robEntry(rs.Dest);
+            float valor = 0.0;
+            if (!loadPodeAcessar(rs.Dest, valor))
+                continue; // Espera: store anterior pode escrever no mesmo endereço
+            portas_livres--;
+
+            // Inicia o acesso à memória (valor lido agora, entregue ao fim da latência)
+            rs.ciclosfaltantes = cycle_times[rs.op] - 1;
+            if (dcache.ativa() && rob_entry.fonte_seq == -1)
+                rs.ciclosfaltantes += acessaCache(rob_entry.pc, rob_entry.enderecoMemoria);
+            rob_entry.estado = executando;
+            rob_entry.acessou_memoria = true;
+            resultado(rob_entry) = valor;
+            loads_executados++;
+            iniciados.push_back(&rs);
+        }
+
+        // 3. Andamento e fim dos acessos, em ordem de posição
+        for (auto &rs : rs_set)
+        {
+            if (!rs.ocupado || rs.op != L_D)
+                continue;
+            ROB_Entry &rob_entry = robEntry(rs.Dest);
+            if (rob_entry.estado != executando)
+                continue;
+            if (rs.ciclosfaltantes > 0 &&
+                std::find(iniciados.begin(), iniciados.end(), &rs) == iniciados.end())
+                rs.ciclosfaltantes--; // Continua execução
+
+            // Final da Execução (Acesso à memória concluído)
+            if (rs.ciclosfaltantes == 0)
+            {
+                rob_entry.estado = escreveresult;
+                conta(modoPRF() ? EV_RF_WRITE : EV_ROB_WRITE);
+                std::cout << "  > EXECUTED (LOAD): " << Instrucao(rs.op, -1, -1, -1).getOpName()
+                          << " (Tag: " << rs.Dest << ") - Mem[" << rob_entry.enderecoMemoria
+                          << "] = " << resultado(rob_entry) << " pronto.\n";
+                if (preditor_valor.ativo())
+                    verificaPrevisao(rs.Dest);
+            }
         }
     };
 
     // --- Lógica para Operações de S.D (Store) ---
-    auto process_store_rs = [&](std::vector<EstacaoReserva> &rs_set) {
+    auto process_store_rs = [&](ConjuntoRS &rs_set) {
         for (auto &rs : rs_set)
         {
             if (rs.ocupado && rs.op == S_D)
             {
-                ROB_Entry &rob_entry = rob.getEntry(rs.Dest);
+                ROB_Entry &rob_entry = robEntry(rs.Dest);
 
                 // 1. Cálculo do Endereço (Depende de Qj)
                 if (rs.Qj == 0 && !rob_entry.enderecocerto)
                 {
-                    // (Simulação de cálculo de endereço)
-                    rob_entry.enderecoMemoria = (long long)rs.Vj + 0; // (0 = imediato)
+                    rs.A = (long long)rs.Vj + rs.A;
+                    rob_entry.enderecoMemoria = rs.A;
                     rob_entry.enderecocerto = true;
                     rob_entry.estado = executando; // Endereço calculado, agora espera o valor
-                    std::cout << "  > EXECUTED (STORE): Endereço calculado (Tag: " << rs.Dest << ")\n";
+                    conta(EV_FU_SD);
+                    conta(EV_ROB_WRITE);
+                    std::cout << "  > EXECUTED (STORE): Endereço Mem[" << rs.A << "] calculado (Tag: " << rs.Dest << ")\n";
+
+                    // 2. Loads mais novos que já leram este endereço leram o valor errado
+                    checkMemoryViolation(rs.Dest);
                 }
             }
         }
     };
 
     // Chamada das lógicas de execução
-    process_arith_rs(rs_add);
-    process_arith_rs(rs_mult);
+    portas_livres = mem_ports;
+    process_arith_rs(rs_add, unidades_add);
+    process_arith_rs(rs_mult, unidades_mult);
     process_load_rs(rs_load);
     process_store_rs(rs_store);
+    if (prefetcher)
+        emitePrefetches();
 }
 
 void TomasuloSimulator::writeResult()
 {
+    PROFILE_FASE(FASE_WRITE_RESULT);
     cdb_broadcast.clear(); // Limpa o CDB do ciclo anterior
     std::vector<EstacaoReserva *> completed_rs_broadcast; // (LD, Arith)
     std::vector<EstacaoReserva *> completed_rs_store;     // (SD)
 
+    // --- 0. Seleção: com CDB_WIDTH, só as vencedoras transmitem neste ciclo ---
+    selecionadas.clear();
+    if (cdb_width > 0)
+    {
+        for (auto *rs_set : {&rs_add, &rs_mult, &rs_load})
+            for (auto &rs : *rs_set)
+                if (rs.ocupado && robEntry(rs.Dest).estado == escreveresult)
+                    selecionadas.push_back(&rs);
+        seleciona(selecionadas, cdb_width);
+        for (auto *rs : selecionadas)
+            rs->selecionada = true;
+    }
+
     // --- 1. Coleta RSs prontas para o CDB (Arith e Load) ---
-    auto check_and_broadcast_cdb = [&](std::vector<EstacaoReserva> &rs_set) {
+    auto check_and_broadcast_cdb = [&](ConjuntoRS &rs_set) {
         for (auto &rs : rs_set)
         {
             if (!rs.ocupado) continue;
             
-            ROB_Entry &rob_entry = rob.getEntry(rs.Dest);
+            ROB_Entry &rob_entry = robEntry(rs.Dest);
 
             // Verifica se a instrução terminou a execução e está pronta para o CDB
-            if (rs.ocupado && rob_entry.estado == escreveresult && cdb_broadcast.find(rs.Dest) == cdb_broadcast.end())
+            int chave = tagCDB(rs.Dest);
+            if (rs.ocupado && rob_entry.estado == escreveresult && cdb_broadcast.find(chave) == cdb_broadcast.end())
             {
+                if (cdb_width > 0 && !rs.selecionada)
+                    continue; // Perdeu o CDB: transmite num próximo ciclo
+
                 // **CORREÇÃO:** Pega o resultado já calculado na fase execute()
-                float result = rob_entry.valor;
+                float result = resultado(rob_entry);
 
                 // --- Atualiza CDB ---
-                cdb_broadcast[rs.Dest] = result;
+                cdb_broadcast[chave] = result;
+                rob_entry.transmitido = true;
+                if (rob_entry.preg >= 0)
+                    prf.pronto[rob_entry.preg] = 1;
+                conta(EV_CDB);
 
                 completed_rs_broadcast.push_back(&rs);
                 std::cout << " > WRITE RESULT: Tag " << rs.Dest << " valor (" << result << ") no CDB.\n";
@@ -643,13 +3267,22 @@ void TomasuloSimulator::writeResult()
     check_and_broadcast_cdb(rs_add);
     check_and_broadcast_cdb(rs_mult);
     check_and_broadcast_cdb(rs_load); // L.D transmite no CDB
+    for (auto *rs : selecionadas)
+        rs->selecionada = false;
 
     // --- 2. Broadcast para OUTRAS RSs (incluindo Store Buffers) ---
-    auto broadcast_to_rs = [&](std::vector<EstacaoReserva> &rs_set) {
-        for (auto &rs : rs_set)
-        {
-            if (rs.ocupado)
+    // Cada estação só compara as próprias tags: com --host-threads o conjunto é dividido em partes
+    auto broadcast_to_rs = [&](ConjuntoRS &rs_set) {
+        if (cdb_broadcast.empty())
+            return;
+        std::vector<ParteVarredura> &partes = partesPara(rs_set.size());
+        varre(rs_set.size(), partes, [&](ParteVarredura &parte, size_t inicio, size_t fim) {
+            for (size_t i = inicio; i < fim; ++i)
             {
+                EstacaoReserva &rs = rs_set[i];
+                if (!rs.ocupado)
+                    continue;
+                parte.conta(EV_RS_COMPARE, 2 * (long long)cdb_broadcast.size());
                 for (const auto &item : cdb_broadcast)
                 {
                     int tag = item.first;
@@ -659,15 +3292,18 @@ void TomasuloSimulator::writeResult()
                     {
                         rs.Vj = value;
                         rs.Qj = 0;
+                        parte.conta(EV_RS_WRITE);
                     }
                     if (rs.Qk == tag)
                     {
                         rs.Vk = value;
                         rs.Qk = 0;
+                        parte.conta(EV_RS_WRITE);
                     }
                 }
             }
-        }
+        });
+        juntaPartes(partes);
     };
 
     broadcast_to_rs(rs_add);
@@ -679,15 +3315,18 @@ void TomasuloSimulator::writeResult()
     // Um Store só fica pronto (escreveresult) quando Qj (endereço) e Qk (valor) estão prontos.
     for (auto &rs : rs_store)
     {
-        ROB_Entry &rob_entry = rob.getEntry(rs.Dest);
+        if (!rs.ocupado)
+            continue;
+        ROB_Entry &rob_entry = robEntry(rs.Dest);
 
         // Qj=0 (endereço calculado no execute) E Qk=0 (valor chegou via CDB)
         // E o endereço já foi calculado (estado = executando)
-        if (rs.ocupado && rs.Qj == 0 && rs.Qk == 0 && rob_entry.estado == executando)
+        if (rs.Qj == 0 && rs.Qk == 0 && rob_entry.estado == executando)
         {
             rob_entry.estado = escreveresult;
             // S.D F2, 0(R1). O valor (Vk) veio de F2.
             rob_entry.valor = rs.Vk; // Guarda o valor a ser escrito no ROB (para o Commit usar)
+            conta(EV_ROB_WRITE);
             completed_rs_store.push_back(&rs);
             std::cout << "  > WRITE RESULT (STORE): Tag " << rs.Dest << " pronto para Commit.\n";
         }
@@ -697,53 +3336,111 @@ void TomasuloSimulator::writeResult()
     // --- 4. Libera as RSs que terminaram ---
     for (auto *rs_ptr : completed_rs_broadcast)
     {
-        rs_ptr->clear();
+        liberaRS(*rs_ptr);
     }
     for (auto *rs_ptr : completed_rs_store)
     {
-        rs_ptr->clear();
+        liberaRS(*rs_ptr);
     }
 }
 
 void TomasuloSimulator::commit()
 {
-    ROB_Entry &head_entry = rob.getcabecaEntry();
-
-    if (head_entry.ocupado && head_entry.estado == escreveresult)
+    PROFILE_FASE(FASE_COMMIT);
+    // Confirma até commit_width entradas por ciclo, sempre em ordem a partir da cabeça.
+    // Com várias threads cada uma confirma em ordem no próprio ROB, e a largura é
+    // dividida em rodízio: uma thread com a cabeça pendente não bloqueia as outras.
+    int confirmadas = 0;
+    int num_threads = (int)threads.size();
+    for (int k = 0; k < num_threads && confirmadas < commit_width; ++k)
     {
-        int rob_tag = rob.getHeadIndex() + 1;
-        
-        // 1. TRATAMENTO DE INSTRUÇÕES QUE ESCREVEM EM REGISTRADORES (L.D, ADD.D, etc.)
-        if (head_entry.op != S_D && head_entry.reddestido != -1)
+        ContextoThread &t = threads[(proxima_thread + k) % num_threads];
+        for (; confirmadas < commit_width; ++confirmadas)
         {
-            // Escrita no Registrador FP
-            fp_registers_values[head_entry.reddestido] = head_entry.valor;
+            ROB_Entry &head_entry = t.rob.getcabecaEntry();
 
-            // Limpeza da Tag
-            reg_status.clearTag(head_entry.reddestido, rob_tag);
+            if (!head_entry.prontaParaCommit())
+                break;
 
-            std::cout << "  > COMMITTED: " << Instrucao(head_entry.op, -1, -1, -1).getOpName()
-                      << " -> F" << head_entry.reddestido << " = " << head_entry.valor << "\n";
-        }
-        // 2. TRATAMENTO DE INSTRUÇÕES S.D
-        else if (head_entry.op == S_D)
-        {
-            // Para S.D, a escrita na memória acontece aqui no Commit
-            std::cout << "  > COMMITTED (MEM): " << Instrucao(head_entry.op, -1, -1, -1).getOpName()
-                      << " -> Escrita Mem[" << head_entry.enderecoMemoria << "] = " 
-                      << head_entry.valor << " realizada.\n";
-        }
+            int rob_tag = t.headTag();
+            conta(EV_ROB_READ);
+
+            // 1. TRATAMENTO DE INSTRUÇÕES QUE ESCREVEM EM REGISTRADORES (L.D, ADD.D, etc.)
+            if (head_entry.op != S_D && head_entry.reddestido != -1)
+            {
+                if (modoPRF())
+                {
+                    // O valor já está no físico: o commit só move o mapa confirmado e
+                    // devolve o físico anterior do destino para a lista livre
+                    t.mapa_commit[head_entry.reddestido] = head_entry.preg;
+                    prf.libera(head_entry.preg_antigo);
+                    conta(EV_RAT_WRITE);
+                }
+                else
+                {
+                    // Escrita no Registrador FP
+                    t.fp_registers_values[head_entry.reddestido] = head_entry.valor;
+                    conta(EV_RF_WRITE);
+                }
+
+                // Limpeza da Tag
+                if (t.reg_status.getTag(head_entry.reddestido) == rob_tag)
+                    conta(EV_RAT_WRITE);
+                t.reg_status.clearTag(head_entry.reddestido, rob_tag);
+
+                std::cout << "  > COMMITTED" << rotuloThread(t) << ": " << Instrucao(head_entry.op, -1, -1, -1).getOpName()
+                          << " -> F" << head_entry.reddestido << " = " << resultado(head_entry) << "\n";
+            }
+            else if (head_entry.preg >= 0)
+                prf.libera(head_entry.preg); // Resultado sem destino arquitetural
+            // 2. TRATAMENTO DE INSTRUÇÕES S.D
+            else if (head_entry.op == S_D)
+            {
+                // Para S.D, a escrita na memória acontece aqui no Commit
+                memoria[head_entry.enderecoMemoria] = head_entry.valor;
+                conta(EV_MEM_WRITE);
+                std::cout << "  > COMMITTED (MEM)" << rotuloThread(t) << ": " << Instrucao(head_entry.op, -1, -1, -1).getOpName()
+                          << " -> Escrita Mem[" << head_entry.enderecoMemoria << "] = " 
+                          << head_entry.valor << " realizada.\n";
+            }
+
+            if (head_entry.op == L_D && head_entry.especulativo)
+                especulacoes_corretas++;
+            if (head_entry.op == L_D && preditor_valor.ativo())
+            {
+                preditor_valor.treinar(head_entry.pc, resultado(head_entry));
+                conta(EV_VPT);
+
+                // Cobertura e acurácia contam só loads confirmados: previsões de loads
+                // descartados por squash (e as verificações deles) não entram
+                vp_loads_verificados++;
+                if (head_entry.fez_previsao)
+                {
+                    vp_previsoes++;
+                    if (head_entry.previsao_correta)
+                        vp_corretas++;
+                    else
+                        vp_incorretas++;
+                }
+            }
 
-        // 3. FINALIZA O COMMIT (SEMPRE DEVE ACONTECER SE A INSTRUÇÃO ESTIVER PRONTA)
-        rob.advancecabeca();
-        instructions_committed++;
+            // 3. FINALIZA O COMMIT (SEMPRE DEVE ACONTECER SE A INSTRUÇÃO ESTIVER PRONTA)
+            t.rob.advancecabeca();
+            t.instructions_committed++;
+            instructions_committed++;
+        }
     }
+
+    if ((int)commit_histogram.size() < commit_width + 1)
+        commit_histogram.resize(commit_width + 1, 0);
+    commit_histogram[confirmadas]++;
 }
 
 // --- FUNÇÕES DE SAÍDA E MAIN ---
 
 void TomasuloSimulator::printSimulatorStatus()
 {
+    PROFILE_FASE(FASE_STATUS);
     std::cout << "\n==================================================\n";
     std::cout << "CICLO " << clock_cycle << "\n";
     std::cout << "==================================================\n";
@@ -754,7 +3451,7 @@ void TomasuloSimulator::printSimulatorStatus()
               << std::setw(7) << "Qj" << std::setw(7) << "Qk" << std::setw(7) << "Vj" << std::setw(7) << "Vk"
               << std::setw(7) << "Dest" << "Ciclos\n";
 
-    auto print_rs_set = [&](const std::vector<EstacaoReserva> &rs_set, const std::string &prefix) {
+    auto print_rs_set = [&](const ConjuntoRS &rs_set, const std::string &prefix) {
         for (const auto &rs : rs_set)
         {
             if (rs.ocupado)
@@ -785,80 +3482,132 @@ void TomasuloSimulator::printSimulatorStatus()
     std::cout << std::left << std::setw(4) << "ID" << std::setw(10) << "Ocupado" << std::setw(14) << "Estado"
               << std::setw(8) << "Destino" << "Valor" << " Endereço\n";
 
-    // Iterar pela lista de forma circular (Head até Tail)
-    int current_index = rob.getHeadIndex();
-    for (int i = 0; i < ROB_SIZE; ++i)
+    // Iterar pela lista de forma circular (Head até Tail), um ROB por thread
+    for (auto &t : threads)
     {
-        ROB_Entry &entry = rob.getEntry(current_index + 1); // +1 para índice 1-base
-        if (entry.ocupado)
+        BufferReordenacao &rob = t.rob;
+        if (threads.size() > 1)
+            std::cout << "Thread " << t.id << ":\n";
+        int current_index = rob.getHeadIndex();
+        for (int i = 0; i < rob.size(); ++i)
         {
-            std::string estado_str;
-            switch (entry.estado)
+            ROB_Entry &entry = rob.getEntry(current_index + 1); // +1 para índice 1-base
+            if (entry.ocupado)
             {
-            case Issue:         estado_str = "Issue";       break;
-            case executando:    estado_str = "Executando";  break;
-            case escreveresult: estado_str = "Pronto";      break;
-            case Commit:        estado_str = "Commit";      break;
-            }
-            
-            std::string dest_str = "Mem";
-            if(entry.op != S_D) {
-                 dest_str = (entry.reddestido != -1) ? ("F" + std::to_string(entry.reddestido)) : "-";
-            }
+                std::string estado_str;
+                switch (entry.estado)
+                {
+                case Issue:         estado_str = "Issue";       break;
+                case executando:    estado_str = "Executando";  break;
+                case escreveresult: estado_str = "Pronto";      break;
+                case Commit:        estado_str = "Commit";      break;
+                }
+                
+                std::string dest_str = "Mem";
+                if(entry.op != S_D) {
+                     dest_str = (entry.reddestido != -1) ? ("F" + std::to_string(entry.reddestido)) : "-";
+                }
 
-            std::cout << std::left << std::setw(4) << (current_index + 1)
-                      << std::setw(10) << "SIM"
-                      << std::setw(14) << estado_str
-                      << std::setw(8) << dest_str
-                      << std::setw(8) << std::fixed << std::setprecision(2) << entry.valor;
-            if(entry.op == L_D || entry.op == S_D) {
-                std::cout << entry.enderecoMemoria;
+                std::cout << std::left << std::setw(4) << (current_index + 1 + t.tag_base)
+                          << std::setw(10) << "SIM"
+                          << std::setw(14) << estado_str
+                          << std::setw(8) << dest_str
+                          << std::setw(8) << std::fixed << std::setprecision(2) << resultado(entry);
+                if(entry.op == L_D || entry.op == S_D) {
+                    std::cout << entry.enderecoMemoria;
+                }
+                std::cout << "\n";
             }
-            std::cout << "\n";
+            
+            if (!entry.ocupado && current_index == rob.getHeadIndex() && i > 0)
+                 break; // Evita loop infinito se vazio
+            if (current_index == (rob.getCaldaIndex() - 1 + rob.size()) % rob.size() && entry.ocupado)
+                break; // Chegou na cauda
+            
+            current_index = (current_index + 1) % rob.size();
         }
-        
-        if (!entry.ocupado && current_index == rob.getHeadIndex() && i > 0)
-             break; // Evita loop infinito se vazio
-        if (current_index == (rob.getCaldaIndex() - 1 + ROB_SIZE) % ROB_SIZE && entry.ocupado)
-            break; // Chegou na cauda
-        
-        current_index = (current_index + 1) % ROB_SIZE;
     }
 
     // 3. STATUS DOS REGISTRADORES
     std::cout << "\n--- STATUS DOS REGISTRADORES (Tags do ROB) ---\n";
     std::cout << std::left << std::setw(5) << "Reg" << "Tag\n";
-    for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+    for (const auto &t : threads)
     {
-        if (reg_status.getTag(i) != 0)
+        if (threads.size() > 1)
+            std::cout << "Thread " << t.id << ":\n";
+        for (int i = 0; i < NUM_FP_REGISTERS; ++i)
         {
-            std::cout << std::left << std::setw(5) << ("F" + std::to_string(i)) << reg_status.getTag(i) << "\n";
+            if (t.reg_status.getTag(i) != 0)
+            {
+                std::cout << std::left << std::setw(5) << ("F" + std::to_string(i)) << t.reg_status.getTag(i) << "\n";
+            }
         }
     }
 }
 
 void TomasuloSimulator::runSimulation()
 {
-    int total_instructions = instruction_queue.size();
+    PROFILE_FASE(FASE_SIMULACAO);
+    int total_instructions = totalInstrucoes();
     if (total_instructions == 0) {
         std::cout << "Nenhuma instrução válida encontrada.\n";
         return;
     }
-    for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+    for (auto &t : threads)
     {
-        fp_registers_values[i] = 1.0; 
+        std::vector<float> &fp_registers_values = t.fp_registers_values;
+        for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+        {
+            fp_registers_values[i] = 1.0; 
+        }
+
+        // Inicializa valores arbitrários nos registradores
+        fp_registers_values[8] = 5.0;  // F8
+        fp_registers_values[4] = 2.0;  // F4
+        fp_registers_values[1] = 1000.0; // R1 (Base 1)
+        fp_registers_values[2] = 2000.0; // R2 (Base 2)
+        fp_registers_values[6] = 10.0; // F6
+
+        // Valores iniciais pedidos no arquivo (REG) sobrescrevem os arbitrários
+        for (const auto &item : valores_iniciais)
+            fp_registers_values[item.first] = item.second;
     }
 
-    // Inicializa valores arbitrários nos registradores
-    fp_registers_values[8] = 5.0;  // F8
-    fp_registers_values[4] = 2.0;  // F4
-    fp_registers_values[1] = 1000.0; // R1 (Base 1)
-    fp_registers_values[2] = 2000.0; // R2 (Base 2)
-    fp_registers_values[6] = 10.0; // F6
+    // Modo PRF: o estado arquitetural inicial de cada thread ocupa os primeiros físicos
+    if (modoPRF())
+    {
+        prf.resize(phys_regs);
+        for (auto &t : threads)
+        {
+            t.mapa.assign(NUM_FP_REGISTERS, -1);
+            for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+            {
+                t.mapa[i] = prf.aloca();
+                prf.valores[t.mapa[i]] = t.fp_registers_values[i];
+                prf.pronto[t.mapa[i]] = 1;
+            }
+            t.mapa_commit = t.mapa;
+        }
+        prf.minimo_livres = prf.disponiveis();
+    }
 
     // Inicia o ciclo de clock em 0
     clock_cycle = 0;
 
+    // Detecção de deadlock: aborta se nenhuma instrução for confirmada por muito tempo
+    // (o limite cresce com a maior latência configurada, para não abortar divisões longas,
+    // e com as faltas das caches, que somam MEM_LATENCY/ICACHE_MISS_LATENCY ao caminho)
+    int maior_latencia = 0;
+    for (const auto &item : cycle_times)
+        maior_latencia = std::max(maior_latencia, item.second);
+    if (dcache.ativa())
+        maior_latencia += mem_latency;
+    if (icache.ativa())
+        maior_latencia += icache_miss_latency;
+    const int limite_sem_commit = 500 + maior_latencia;
+    int ultimo_commit_ciclo = 0;
+    int committed_antes = 0;
+
     while (instructions_committed < total_instructions)
     {
         clock_cycle++;
@@ -870,98 +3619,417 @@ void TomasuloSimulator::runSimulation()
         writeResult();
         execute();
         issue();
+        if (front_end)
+            fetch(); // Buscadas agora chegam ao issue depois de decode_latency ciclos
+        proxima_thread = (proxima_thread + 1) % (int)threads.size();
 
-        printSimulatorStatus();
+        if (imprime_status)
+            printSimulatorStatus();
 
-        if(clock_cycle > 500) {
-             std::cout << "Simulação excedeu 500 ciclos (possível deadlock). Abortando.\n";
+        if (instructions_committed != committed_antes)
+        {
+            committed_antes = instructions_committed;
+            ultimo_commit_ciclo = clock_cycle;
+        }
+        if (clock_cycle - ultimo_commit_ciclo > limite_sem_commit) {
+             std::cout << "Simulação ficou " << limite_sem_commit
+                       << " ciclos sem commit (possível deadlock). Abortando.\n";
+             abortada = true;
              break;
         }
     }
 
+    PROFILE_INSTRUCOES(instructions_committed);
+
+    // Modo PRF: o banco arquitetural é o que o mapa confirmado aponta
+    if (modoPRF())
+        for (auto &t : threads)
+            for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+                t.fp_registers_values[i] = prf.valores[t.mapa_commit[i]];
+}
+
+// Resumo depois do trace: ciclos, registradores finais e estatísticas. É também o
+// que o cache de resultados guarda.
+void TomasuloSimulator::printResultados()
+{
     // Imprime o estado final dos registradores
-    std::cout << "\n\n=== SIMULAÇÃO CONCLUÍDA em " << clock_cycle << " CICLOS ===\n";
-    std::cout << "\n--- VALORES FINAIS DOS REGISTRADORES FP ---\n";
-    for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+    std::cout << "\n\n=== SIMULAÇÃO " << (abortada ? "ABORTADA" : "CONCLUÍDA") << " em " << clock_cycle
+              << " CICLOS ===\n";
+    for (const auto &t : threads)
+    {
+        std::cout << "\n--- VALORES FINAIS DOS REGISTRADORES FP";
+        if (threads.size() > 1)
+            std::cout << " (THREAD " << t.id << ")";
+        std::cout << " ---\n";
+        for (int i = 0; i < NUM_FP_REGISTERS; ++i)
+        {
+            if (t.fp_registers_values[i] != 0.0)
+            {
+                std::cout << "F" << i << ": " << std::fixed << std::setprecision(2) << t.fp_registers_values[i] << "\n";
+            }
+        }
+    }
+
+    printStatistics();
+}
+
+void TomasuloSimulator::printStatistics()
+{
+    std::cout << "\n=== ESTATÍSTICAS ===\n";
+    std::cout << "Largura: ISSUE_WIDTH " << issue_width << ", COMMIT_WIDTH " << commit_width
+              << ", ROB_SIZE " << rob_size << "\n";
+    std::cout << "Instruções confirmadas: " << instructions_committed << "\n";
+    std::cout << "Ciclos: " << clock_cycle << "\n";
+    std::cout << "IPC: " << std::fixed << std::setprecision(2)
+              << (clock_cycle > 0 ? (double)instructions_committed / clock_cycle : 0.0) << "\n";
+    if (threads.size() > 1)
+    {
+        std::cout << "Threads: " << threads.size() << " (FETCH_POLICY "
+                  << (fetch_policy == FETCH_ICOUNT ? "ICOUNT" : "ROUND_ROBIN") << ", ROB_PARTITION "
+                  << (rob_partition == ROB_STATIC ? "STATIC" : "SHARED") << ", " << tag_stride
+                  << " entradas de ROB por thread)\n";
+        for (const auto &t : threads)
+            std::cout << "  Thread " << t.id << ": " << t.instructions_committed << "/" << t.total_instructions
+                      << " instruções, IPC " << std::fixed << std::setprecision(2)
+                      << (clock_cycle > 0 ? (double)t.instructions_committed / clock_cycle : 0.0) << "\n";
+    }
+
+    auto print_histogram = [&](const std::string &nome, const std::vector<long long> &hist) {
+        std::cout << nome << " por ciclo (instruções: ciclos):";
+        for (size_t k = 0; k < hist.size(); ++k)
+            std::cout << " " << k << ":" << hist[k];
+        std::cout << "\n";
+    };
+    print_histogram("Despacho", issue_histogram);
+    print_histogram("Commit", commit_histogram);
+
+    if (modoPRF())
+    {
+        int arquiteturais = NUM_FP_REGISTERS * (int)threads.size();
+        std::cout << "\n--- RENOMEAÇÃO (RENAME_MODE PRF) ---\n";
+        std::cout << "Registradores físicos: " << prf.size() << " (" << arquiteturais << " arquiteturais + "
+                  << prf.size() - arquiteturais << " para renomeação)\n";
+        std::cout << "Menor lista livre: " << prf.minimo_livres << " (pico em uso para renomeação: "
+                  << prf.size() - arquiteturais - (int)prf.minimo_livres << ")\n";
+        std::cout << "Despachos barrados por falta de físico: " << stalls_registrador_fisico << "\n";
+    }
+
+    if (front_end)
+    {
+        auto pct = [](long long a, long long b) { return b > 0 ? 100.0 * a / b : 0.0; };
+        std::cout << "\n--- FRONT-END (FETCH_WIDTH " << fetch_width << ", DECODE_LATENCY " << decode_latency
+                  << ", IQ_SIZE " << iq_size << ") ---\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Instruções buscadas: " << instrucoes_buscadas << " (descartadas da fila num squash: "
+                  << instrucoes_descartadas_fila << ")\n";
+        if (icache.ativa())
+        {
+            long long acessos = icache_acertos + icache_faltas;
+            std::cout << "Cache de instruções (" << icache.num_linhas << " linhas, " << icache.assoc << " vias, "
+                      << icache.tamanho_linha << " B/linha, falta +" << icache_miss_latency
+                      << " ciclos): " << acessos << " acessos, " << icache_faltas << " faltas (taxa de faltas: "
+                      << pct(icache_faltas, acessos) << "%)\n";
+        }
+        std::cout << "Busca parada: " << ciclos_fetch_icache << " ciclos esperando a cache de instruções, "
+                  << ciclos_fetch_fila_cheia << " com a fila de decodificadas cheia\n";
+        std::cout << "Issue faminto (back end com vaga, nada decodificado): " << ciclos_issue_faminto
+                  << " ciclos (" << pct(ciclos_issue_faminto, clock_cycle) << "%), " << vagas_issue_famintas
+                  << " vagas de issue perdidas\n";
+        std::cout << "Issue saturado (instrução pronta, back end cheio): " << ciclos_issue_saturado << " ciclos ("
+                  << pct(ciclos_issue_saturado, clock_cycle) << "%)\n";
+    }
+
+    if (selecao_disputas > 0)
+    {
+        const char *politicas[] = {"OLDEST", "POSITION", "RANDOM"};
+        std::cout << "\n--- SELEÇÃO (SELECT_POLICY " << politicas[select_policy] << ") ---\n";
+        std::cout << "Recursos: unidades ADD " << (unidades_add > 0 ? std::to_string(unidades_add) : "por estação")
+                  << ", unidades MULT " << (unidades_mult > 0 ? std::to_string(unidades_mult) : "por estação")
+                  << ", portas de memória " << mem_ports << ", CDB "
+                  << (cdb_width > 0 ? std::to_string(cdb_width) : "sem limite") << "\n";
+        std::cout << "Disputas (mais prontas que recursos): " << selecao_disputas << "\n";
+        std::cout << "Adiamentos (pronta que perdeu a disputa): " << selecao_adiadas << "\n";
+    }
+
+    if (loads_executados > 0 || violacoes_memoria > 0)
     {
-        if (fp_registers_values[i] != 0.0)
+        const char *modos[] = {"CONSERVATIVE", "STORE_SETS", "SPECULATIVE"};
+        std::cout << "\n--- MEMÓRIA (MEM_DEP " << modos[mem_dep] << ") ---\n";
+        std::cout << "Acessos de load: " << loads_executados << " (forwarding de store: " << loads_forwarding << ")\n";
+        std::cout << "Loads especulativos (passaram store sem endereço): " << loads_especulativos << "\n";
+        std::cout << "Stalls conservadores evitados (especulação correta): " << especulacoes_corretas << "\n";
+        std::cout << "Loads retidos pelo preditor: " << loads_retidos_preditor << "\n";
+        std::cout << "Violações de ordem de memória: " << violacoes_memoria << "\n";
+        std::cout << "Instruções descartadas (squash): " << instrucoes_descartadas << "\n";
+    }
+
+    if (preditor_valor.ativo())
+    {
+        auto pct = [](long long a, long long b) { return b > 0 ? 100.0 * a / b : 0.0; };
+        std::cout << "\n--- PREVISÃO DE VALORES (VALUE_PRED "
+                  << (preditor_valor.tipo == VP_STRIDE ? "STRIDE" : "LAST_VALUE") << ") ---\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Loads verificados: " << vp_loads_verificados << "\n";
+        std::cout << "Previsões: " << vp_previsoes << " (cobertura: " << pct(vp_previsoes, vp_loads_verificados) << "%)\n";
+        std::cout << "Corretas: " << vp_corretas << ", incorretas: " << vp_incorretas
+                  << " (acurácia: " << pct(vp_corretas, vp_corretas + vp_incorretas) << "%)\n";
+        std::cout << "Operandos entregues com valor previsto: " << vp_consumos << "\n";
+        std::cout << "Recuperações: " << vp_recuperacoes << " (instruções descartadas: " << vp_descartadas << ")\n";
+        if (ciclos_sem_vp >= 0)
+            std::cout << "Ciclos sem previsão: " << ciclos_sem_vp << ", economia líquida: "
+                      << ciclos_sem_vp - clock_cycle << " ciclos ("
+                      << pct(ciclos_sem_vp - clock_cycle, ciclos_sem_vp) << "%)\n";
+    }
+
+    if (dcache.ativa())
+    {
+        long long acessos = dcache_acertos + dcache_faltas;
+        auto pct = [](long long a, long long b) { return b > 0 ? 100.0 * a / b : 0.0; };
+        std::cout << "\n--- CACHE DE DADOS (" << dcache.num_linhas << " linhas, " << dcache.assoc << " vias, "
+                  << dcache.tamanho_linha << " B/linha, falta +" << mem_latency << " ciclos) ---\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Acessos de demanda: " << acessos << " (acertos: " << dcache_acertos
+                  << ", faltas: " << dcache_faltas << ", taxa de faltas: " << pct(dcache_faltas, acessos) << "%)\n";
+        if (prefetcher)
         {
-            std::cout << "F" << i << ": " << std::fixed << std::setprecision(2) << fp_registers_values[i] << "\n";
+            std::cout << "Prefetcher: " << prefetcher->nome() << " (grau " << prefetch_degree
+                      << ", distância " << prefetch_distance << ")\n";
+            std::cout << "Prefetches emitidos: " << prefetches_emitidos << " (úteis: " << prefetches_uteis
+                      << ", tardios: " << prefetches_tardios << ", inúteis despejados: " << prefetches_inuteis
+                      << ", descartados com a fila cheia: " << prefetches_descartados << ")\n";
+            std::cout << "Acurácia: " << pct(prefetches_uteis, prefetches_emitidos) << "%\n";
+            std::cout << "Cobertura: " << pct(prefetches_uteis, prefetches_uteis + dcache_faltas) << "%\n";
+            std::cout << "Pontualidade: " << pct(prefetches_uteis - prefetches_tardios, prefetches_uteis) << "%\n";
         }
     }
+
+    printEnergy();
+}
+
+void TomasuloSimulator::printEnergy()
+{
+    std::cout << "\n--- ATIVIDADE E ENERGIA ---\n";
+    std::cout << std::left << std::setw(12) << "Evento" << std::setw(14) << "Acessos"
+              << std::setw(10) << "pJ/acesso" << "Energia (nJ)\n";
+
+    double dinamica_pj = 0.0;
+    for (int e = 0; e < NUM_EVENTOS; ++e)
+    {
+        double pj = atividade[e] * energia_pj[e];
+        dinamica_pj += pj;
+        std::cout << std::left << std::setw(12) << EventosInfo[e].nome << std::setw(14) << atividade[e]
+                  << std::setw(10) << std::fixed << std::setprecision(2) << energia_pj[e]
+                  << std::setprecision(3) << pj / 1000.0 << "\n";
+    }
+
+    double estatica_pj = energia_estatica_pj * clock_cycle;
+    double total_nj = (dinamica_pj + estatica_pj) / 1000.0;
+    double tempo_ns = clock_cycle / clock_ghz;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Energia dinâmica: " << dinamica_pj / 1000.0 << " nJ\n";
+    std::cout << "Energia estática: " << estatica_pj / 1000.0 << " nJ (" << energia_estatica_pj << " pJ/ciclo)\n";
+    std::cout << "Energia total: " << total_nj << " nJ\n";
+    std::cout << "Energia por instrução: "
+              << (instructions_committed > 0 ? total_nj / instructions_committed : 0.0) << " nJ\n";
+    std::cout << "Potência média: " << (tempo_ns > 0 ? total_nj / tempo_ns : 0.0) << " W (a "
+              << clock_ghz << " GHz)\n";
+    std::cout << "Energy-delay product: " << total_nj * tempo_ns << " nJ*ns\n";
+
+    // Linha única para varreduras automatizadas (grep RESUMO_ENERGIA)
+    std::cout << "RESUMO_ENERGIA ciclos=" << clock_cycle << " instrucoes=" << instructions_committed
+              << " energia_nj=" << total_nj << " edp_nj_ns=" << total_nj * tempo_ns
+              << " ipc=" << (clock_cycle > 0 ? (double)instructions_committed / clock_cycle : 0.0) << "\n";
 }
 
+// Redireciona o std::cout enquanto existir; o buffer anterior volta no fim do
+// escopo, inclusive quando uma exceção sai da simulação
+class RedirecionaCout
+{
+private:
+    std::streambuf *anterior;
+
+public:
+    explicit RedirecionaCout(std::streambuf *destino) : anterior(std::cout.rdbuf(destino)) {}
+    ~RedirecionaCout()
+    {
+        std::cout.clear(); // Sem buffer (saída descartada) o cout fica em badbit
+        std::cout.rdbuf(anterior);
+    }
+};
+
 int main(int argc, char *argv[])
 {
-    // --- MODIFICADO ---
-    // Agora esperamos 3 argumentos: ./programa <entrada> <saida>
-    if (argc != 3)
+    // Uso: ./programa [--parse-only] [--cache <dir>] [--cache-max-mb <n>] [--no-cache]
+    //                 [--host-threads <n>] [--no-status] [--no-vp-baseline] <entrada> <saida>
+    // Sem --cache, o diretório do cache vem de TOMASULO_CACHE_DIR (se definida)
+    TomasuloSimulator simulator;
+    bool parse_only = false;
+    bool vp_referencia = true; // Com VALUE_PRED, roda também a entrada sem previsão
+    const char *env_cache = std::getenv("TOMASULO_CACHE_DIR");
+    std::string cache_dir = env_cache ? env_cache : "";
+    int cache_max_mb = CACHE_MAX_MB;
+    int host_threads = 1;
+    bool uso_invalido = false;
+    std::vector<std::string> posicionais;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--parse-only")
+            parse_only = true;
+        else if (arg == "--no-cache")
+            cache_dir.clear();
+        else if (arg == "--no-status")
+            simulator.imprime_status = false;
+        else if (arg == "--no-vp-baseline")
+            vp_referencia = false;
+        else if ((arg == "--cache" || arg == "--cache-max-mb" || arg == "--host-threads") && i + 1 < argc)
+        {
+            std::string valor = argv[++i];
+            if (arg == "--cache")
+                cache_dir = valor;
+            else if (arg == "--cache-max-mb")
+                uso_invalido = uso_invalido || (cache_max_mb = std::atoi(valor.c_str())) <= 0;
+            else
+                uso_invalido = uso_invalido || (host_threads = std::atoi(valor.c_str())) <= 0;
+        }
+        else
+            posicionais.push_back(arg);
+    }
+    if (posicionais.size() != 2 || uso_invalido)
     {
         // Esta mensagem de erro ainda vai para o console
-        std::cerr << "Uso: " << argv[0] << " <arquivo_de_entrada.txt> <arquivo_de_saida.txt>\n";
+        std::cerr << "Uso: " << argv[0] << " [--parse-only] [--cache <dir>] [--cache-max-mb <n>] [--no-cache]"
+                  << " [--host-threads <n>] [--no-status] [--no-vp-baseline]"
+                  << " <arquivo_de_entrada.txt> <arquivo_de_saida.txt>\n";
         return 1;
     }
+    const std::string &input_path = posicionais[0];
+    const std::string &output_path = posicionais[1];
 
-    std::ifstream inputFile(argv[1]);
-    if (!inputFile.is_open())
+    std::unique_ptr<CacheResultados> cache;
+    if (!cache_dir.empty() && !parse_only)
     {
-        std::cerr << "Erro: Não foi possível abrir o arquivo de entrada " << argv[1] << "\n";
+        cache.reset(new CacheResultados(cache_dir, cache_max_mb, argv[0]));
+        if (!cache->ativo())
+        {
+            std::cerr << "Aviso: diretório de cache '" << cache_dir << "' não existe; cache desligado.\n";
+            cache.reset();
+        }
+    }
+
+    // 1. Carregar configuração e instruções (passada única; erros vão para o console)
+    simulator.calcula_assinatura = (cache != nullptr);
+    auto inicio_leitura = std::chrono::steady_clock::now();
+    if (!simulator.loadInput(input_path))
         return 1;
+    double ms_leitura = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio_leitura).count();
+    if (!vp_referencia && simulator.preditor_valor.ativo())
+    {
+        // Sem a execução de referência o resumo muda (sem economia líquida): outra entrada no cache
+        const char marca[] = "--no-vp-baseline\n";
+        simulator.assinatura.adiciona(marca, sizeof(marca) - 1);
+    }
+
+    if (parse_only)
+    {
+        std::cout << "Leitura de '" << input_path << "': " << simulator.input_lines << " linhas, "
+                  << simulator.totalInstrucoes() << " instruções em " << std::fixed
+                  << std::setprecision(2) << ms_leitura << " ms ("
+                  << (ms_leitura > 0 ? simulator.input_lines / (ms_leitura * 1000.0) : 0.0)
+                  << " milhões de linhas/s).\n";
+#ifdef TOMASULO_PROFILE
+        imprimeProfiler(std::cout, simulator.profiler, simulator.clock_cycle);
+#endif
+        return 0;
     }
 
-    // --- NOVO CÓDIGO ---
-    
-    // 1. Abrir o arquivo de saída
-    std::ofstream output_file(argv[2]);
+    // 2. Abrir o arquivo de saída
+    std::ofstream output_file(output_path);
     if (!output_file.is_open())
     {
-        std::cerr << "Erro: Não foi possível criar o arquivo de saída " << argv[2] << "\n";
+        std::cerr << "Erro: Não foi possível criar o arquivo de saída " << output_path << "\n";
         return 1;
     }
 
-    // 2. Salvar o buffer original do std::cout (o console)
+    // 3. Salvar o buffer original do std::cout (o console)
     auto* original_cout_buffer = std::cout.rdbuf();
 
-    // 3. Redirecionar o std::cout para o buffer do nosso arquivo
+    // 4. Redirecionar o std::cout para o buffer do nosso arquivo
     // A partir deste ponto, todo std::cout escreve em output_file
     std::cout.rdbuf(output_file.rdbuf());
 
-    // --- FIM DO NOVO CÓDIGO ---
-
-
-    TomasuloSimulator simulator;
-
-    // 1. Carregar Configuração
-    simulator.loadConfiguration(inputFile);
-
-    // Reinicia a leitura do arquivo para a seção de instruções
-    inputFile.clear();
-    inputFile.seekg(0, std::ios::beg);
-
-    // 2. Carregar Instruções
-    simulator.loadInstructions(inputFile);
-
-    if (simulator.instruction_queue.empty())
+    if (simulator.totalInstrucoes() == 0)
     {
         // Esta mensagem agora irá para o arquivo de saída
         std::cout << "Nenhuma instrução válida encontrada. Simulação encerrada.\n";
+        std::cout.rdbuf(original_cout_buffer);
         return 0;
     }
 
-    // 3. Executar Simulação
-    // Todas as saídas de runSimulation() irão para o arquivo
-    simulator.runSimulation();
+    // Acerto no cache: a mesma entrada já foi simulada por este mesmo executável
+    std::string resultado_cache;
+    if (cache && cache->procura(simulator.assinatura, resultado_cache))
+    {
+        std::cout << "Resultado do cache de simulação (" << cache_dir
+                  << "); trace ciclo a ciclo omitido.\n" << resultado_cache;
+        std::cout.rdbuf(original_cout_buffer);
+        std::cout << "Simulação reaproveitada do cache. Resultados salvos em '" << output_path << "'.\n";
+        return 0;
+    }
 
+    // 5. Com VALUE_PRED, roda antes a mesma entrada sem previsão (saída descartada)
+    // para medir a economia líquida de ciclos. É uma segunda simulação completa, que
+    // dobra o custo da execução; --no-vp-baseline a omite
+    if (simulator.preditor_valor.ativo() && vp_referencia)
+    {
+        TomasuloSimulator referencia;
+        if (referencia.loadInput(input_path))
+        {
+            referencia.preditor_valor.tipo = VP_NONE;
+            referencia.imprime_status = false; // As tabelas seriam formatadas só para o descarte
+            RedirecionaCout descarta(nullptr);
+            referencia.runSimulation();
+            if (!referencia.abortada)
+                simulator.ciclos_sem_vp = referencia.clock_cycle;
+        }
+        else
+            std::cerr << "Aviso: não foi possível reler '" << input_path
+                      << "' para a execução sem VALUE_PRED; economia líquida omitida.\n";
+    }
 
-    // --- NOVO CÓDIGO (Boa prática) ---
+    // 6. Executar Simulação
+    // Todas as saídas de runSimulation() irão para o arquivo
+    if (host_threads > 1)
+        simulator.pool.reset(new PoolThreads(host_threads));
+    simulator.runSimulation();
+    if (cache && !simulator.abortada) // Resultado parcial de um deadlock não vai para o cache
+    {
+        // O resumo vai para o arquivo e, igual, para o cache
+        std::ostringstream resultados;
+        {
+            RedirecionaCout captura(resultados.rdbuf());
+            simulator.printResultados();
+        }
+        std::cout << resultados.str();
+        cache->guarda(simulator.assinatura, resultados.str());
+    }
+    else
+        simulator.printResultados();
 
-    // 4. Restaurar o buffer original do std::cout
+    // 7. Restaurar o buffer original do std::cout
     std::cout.rdbuf(original_cout_buffer);
 
-    // 5. Imprimir uma mensagem final no console (agora que o cout foi restaurado)
-    std::cout << "Simulação concluída. Resultados salvos em '" << argv[2] << "'.\n";
-
-    // --- FIM DO NOVO CÓDIGO ---
+    // 8. Imprimir uma mensagem final no console (agora que o cout foi restaurado)
+    if (simulator.abortada)
+    {
+        std::cerr << "Erro: simulação abortada por possível deadlock após " << simulator.clock_cycle
+                  << " ciclos; resultado parcial em '" << output_path << "'.\n";
+        return 1;
+    }
+    std::cout << "Simulação concluída. Resultados salvos em '" << output_path << "'.\n";
+#ifdef TOMASULO_PROFILE
+    imprimeProfiler(std::cout, simulator.profiler, simulator.clock_cycle);
+#endif
 
     return 0;
 }
\ No newline at end of file